@@ -17,16 +17,52 @@
 
 #include "paal/data_structures/metric/metric_traits.hpp"
 #include "paal/data_structures/metric/graph_metrics.hpp"
+#include "paal/data_structures/work_stealing_pool.hpp"
 
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
-#include <bitset>
+#include <vector>
 
 namespace paal {
 
+/**
+ * How dreyfus_wagner fills its tables.
+ */
+enum class dreyfus_wagner_engine {
+    recursive, // top-down and memoized, only the states reachable from start
+    iterative  // bottom-up, by increasing number of terminals to connect
+};
+
 /**
  * Implements Dreyfus-Wagner algorithm.
  * The algorithm finds optimal Steiner Tree in exponential time, 3^k * n.
+ * The memoized states are kept between calls to solve(), so the tree can be
+ * re-solved incrementally after removing non-terminals, and after allowing
+ * some again when the caller knows they improve no state.
+ *
+ * States are stored in flat tables : vertices are numbered 0..n-1 (terminals
+ * first), and the terminals still to be connected form a bit mask over the
+ * k-1 terminals other than the start one, so each table is a contiguous
+ * cost[mask][vertex] array of 2^(k-1) * n cells.
+ *
+ * Both engines fill the same tables with the same tie-breaking, so they give
+ * the same trees.
+ *
+ * A terminal can also be added or removed between calls to solve() : the
+ * states of the other terminals are kept, renumbered. So can non-terminals,
+ * their columns of the tables and their distances going along.
  */
 template <typename Metric, typename Terminals, typename NonTerminals,
 		  unsigned int TerminalsLimit = 32>
@@ -36,42 +72,116 @@ class dreyfus_wagner {
     using Vertex = typename MT::VertexType;
     using Dist = typename MT::DistanceType;
     using Edge = typename std::pair<Vertex, Vertex>;
-    using TerminalsBitSet = typename std::bitset<TerminalsLimit>;
-    using State = std::pair<Vertex, TerminalsBitSet>;
+    using TerminalsMask = typename std::conditional<(TerminalsLimit <= 32),
+                                                    std::uint32_t,
+                                                    std::uint64_t>::type;
     using steiner_elements =  std::unordered_set<Vertex, boost::hash<Vertex>>;
 
     /**
      * Constructor used for solving Steiner Tree problem.
      */
     dreyfus_wagner(const Metric &cost_map, const Terminals &term,
-				   /*const*/ NonTerminals &non_terminals)
-        : m_cost_map(cost_map), m_terminals(term),
-          m_non_terminals(non_terminals) {
+                   const NonTerminals &non_terminals)
+        : m_cost_map(&cost_map), m_terminals_count(term.size()),
+          m_engine(dreyfus_wagner_engine::recursive), m_stopped(false),
+          m_start(-1) {
 
-		assert((uint)m_terminals.size() <= TerminalsLimit);
-        for (int i = 0; i < (int)m_terminals.size(); i++) {
-            m_elements_map[m_terminals[i]] = i;
+		assert((uint)m_terminals_count <= TerminalsLimit);
+        for (auto t : term) {
+            index_vertex(t);
+        }
+        assert(m_vertices.size() == (std::size_t)m_terminals_count);
+        m_allowed.resize(m_vertices.size());
+        for (auto v : non_terminals) {
+            int id = index_vertex(v);
+            m_allowed.resize(m_vertices.size());
+            if (id < m_terminals_count || m_allowed.test(id)) continue;
+            m_allowed.set(id);
+            m_non_terminals.push_back(id);
         }
     }
 
     /**
      * Finds optimal Steiner Tree.
      * @param start Vertex to start the recurrence from.
+     * @return false when the stop condition interrupted it : the tables are
+     * then dropped, and the next call rebuilds them.
      */
-    void solve(int start = 0) {
-        int n = m_elements_map.size();
-        assert(start >= 0 && start < n);
-        TerminalsBitSet remaining;
-        // set all terminals except 'start' to 1
-        for (int i = 0; i < n; i++) {
-            remaining.set(i);
+    bool solve(int start = 0) {
+        assert(start >= 0 && start < m_terminals_count);
+        if (start != m_start) {
+            init_tables(start);
         }
-        remaining.reset(start);
+        // all terminals except 'start' are still to be connected
+        TerminalsMask remaining = full_mask();
 
-        m_cost = connect_vertex(m_terminals[start], remaining);
-        retrieve_solution_connect(m_terminals[start], remaining);
+        m_edges.clear();
+        m_steiner_elements.clear();
+        m_stopped = false;
+        if (m_engine == dreyfus_wagner_engine::iterative) {
+            fill_tables();
+        }
+        if (!m_stopped) m_cost = connect_vertex(start, remaining);
+        // the states computed after the stop hold partial costs
+        if (m_stopped) {
+            drop_tables();
+            return false;
+        }
+        retrieve_solution_connect(start, remaining);
+        return true;
     }
 
+    /**
+     * Selects how the next calls to solve() fill the tables.
+     */
+    void set_engine(dreyfus_wagner_engine engine) { m_engine = engine; }
+
+    /**
+     * Fills each layer of the tables with the given number of threads,
+     * iterative engine only. Copies of this object share the threads.
+     */
+    void set_threads_count(unsigned threads_count) {
+        if (threads_count <= 1) {
+            m_pool.reset();
+        } else if (!m_pool || m_pool->get_threads_count() != threads_count) {
+            m_pool = std::make_shared<data_structures::work_stealing_pool>(
+                threads_count);
+        }
+    }
+
+    /**
+     * Fills each layer of the tables with the threads of the given pool,
+     * none if null. Its loops are not reentrant : copies solved concurrently
+     * must not share it.
+     */
+    void set_pool(std::shared_ptr<data_structures::work_stealing_pool> pool) {
+        m_pool = std::move(pool);
+    }
+
+    const std::shared_ptr<data_structures::work_stealing_pool> &get_pool() const {
+        return m_pool;
+    }
+
+    /**
+     * Sets a condition checked while solve() fills the tables, before each
+     * layer and each mask, and before each state the recursion computes :
+     * once it holds, solve() gives up. Copies share it, so it may be called
+     * from the pool threads.
+     */
+    void set_stop_condition(std::function<bool()> stop) {
+        m_stop = std::move(stop);
+    }
+
+    /**
+     * Tells whether the given vertex may be used as a Steiner vertex.
+     */
+    bool is_allowed(Vertex v) const {
+        auto iter = m_index.find(v);
+        return iter != m_index.end() && m_allowed.test(iter->second);
+    }
+
+    dreyfus_wagner_engine get_engine() const { return m_engine; }
+
     /**
      * Gets the optimal Steiner Tree cost.
      */
@@ -89,108 +199,388 @@ class dreyfus_wagner {
         return m_steiner_elements;
     }
 
-    const Metric get_cost_map() const {return m_cost_map;};
+    const Metric get_cost_map() const {return *m_cost_map;};
 
-//private:
+    /**
+     * Measures the vertices added from now on with the given metric, which
+     * must give the same distances between the vertices measured already :
+     * they are kept.
+     */
+    void set_cost_map(const Metric &cost_map) { m_cost_map = &cost_map; }
+
+    /**
+     * Gets the memory used by the tables once solve() is called, in bytes.
+     */
+    std::size_t get_memory_usage() const {
+        return memory_usage(m_terminals_count, m_vertices.size());
+    }
+
+    std::size_t get_terminals_count() const { return m_terminals_count; }
+
+    std::size_t get_vertices_count() const { return m_vertices.size(); }
+
+    /**
+     * Gets the memory used by the tables and the distances for a given
+     * problem size, in bytes, or the largest std::size_t if it does not fit.
+     */
+    static std::size_t memory_usage(std::size_t terminals_count,
+                                    std::size_t vertices_count) {
+        std::size_t tables = tables_memory_usage(terminals_count, vertices_count);
+        std::size_t distances = distances_memory_usage(vertices_count);
+        const std::size_t max = std::numeric_limits<std::size_t>::max();
+        return tables > max - distances ? max : tables + distances;
+    }
+
+    /**
+     * Gets the memory used by the tables alone, in bytes, or the largest
+     * std::size_t if it does not fit.
+     */
+    static std::size_t tables_memory_usage(std::size_t terminals_count,
+                                           std::size_t vertices_count) {
+        const std::size_t max = std::numeric_limits<std::size_t>::max();
+        const std::size_t cell_size =
+            2 * sizeof(Dist) + sizeof(int) + sizeof(TerminalsMask);
+        if (terminals_count == 0 || vertices_count == 0) return 0;
+        if (terminals_count - 1 >= (std::size_t)std::numeric_limits<std::size_t>::digits) {
+            return max;
+        }
+        std::size_t masks = std::size_t(1) << (terminals_count - 1);
+        if (masks > max / vertices_count / cell_size) return max;
+        return masks * vertices_count * cell_size;
+    }
+
+    /**
+     * Gets the memory used by the distances between the vertices, in bytes,
+     * or the largest std::size_t if it does not fit. Copies share them.
+     */
+    static std::size_t distances_memory_usage(std::size_t vertices_count) {
+        const std::size_t max = std::numeric_limits<std::size_t>::max();
+        if (vertices_count == 0) return 0;
+        if (vertices_count > max / vertices_count / sizeof(Dist)) return max;
+        return vertices_count * vertices_count * sizeof(Dist);
+    }
+
+    /**
+     * Maximal number of terminals.
+     */
+    static constexpr unsigned terminals_limit = TerminalsLimit;
+
+    /**
+     * Forbids the given non-terminals. Only the memoized states whose
+     * optimal solution goes through one of them are invalidated, the others
+     * stay optimal since the removal can only make the other choices worse.
+     */
+    template <typename Vertices>
+    void remove_non_terminals(const Vertices &vertices) {
+        std::vector<char> removed(m_vertices.size(), false);
+        bool any = false;
+        for (auto v : vertices) {
+            auto iter = m_index.find(v);
+            if (iter != m_index.end() && m_allowed.test(iter->second)) {
+                m_allowed.reset(iter->second);
+                removed[iter->second] = any = true;
+            }
+        }
+        if (!any) return;
+
+        auto end = std::remove_if(m_non_terminals.begin(), m_non_terminals.end(),
+                                  [&](int w) { return removed[w]; });
+        m_non_terminals.erase(end, m_non_terminals.end());
+        if (m_start < 0) return;
+
+        // Mark first, then clear : marking follows the back-pointers
+        std::vector<char> connect_marks(m_cand_cost.size(), unmarked);
+        std::vector<char> split_marks(m_split_cost.size(), unmarked);
+        int n = m_vertices.size();
+        for (std::size_t cell = 0; cell < m_cand_cost.size(); cell++) {
+            if (m_cand_cost[cell] >= 0) {
+                connect_uses(cell % n, cell / n, removed, connect_marks, split_marks);
+            }
+        }
+        for (std::size_t cell = 0; cell < m_split_cost.size(); cell++) {
+            if (m_split_cost[cell] >= 0) {
+                split_uses(cell % n, cell / n, removed, connect_marks, split_marks);
+            }
+        }
+        for (std::size_t cell = 0; cell < m_cand_cost.size(); cell++) {
+            if (connect_marks[cell] == marked_used) m_cand_cost[cell] = -1;
+            if (split_marks[cell] == marked_used) m_split_cost[cell] = -1;
+        }
+    }
+
+    /**
+     * Forgets the given non-terminals : they are forbidden as by
+     * remove_non_terminals, then their columns of the tables and their
+     * distances are dropped, the next vertices moving down.
+     */
+    template <typename Vertices>
+    void erase_non_terminals(const Vertices &vertices) {
+        std::vector<char> erased(m_vertices.size(), false);
+        bool any = false;
+        for (auto v : vertices) {
+            auto iter = m_index.find(v);
+            if (iter == m_index.end()) continue;
+            assert(iter->second >= m_terminals_count);
+            erased[iter->second] = any = true;
+        }
+        if (!any) return;
+
+        remove_non_terminals(vertices);
+        std::vector<int> number(m_vertices.size());
+        int count = 0;
+        for (std::size_t v = 0; v < number.size(); v++) {
+            number[v] = erased[v] ? -1 : count++;
+        }
+        renumber(number, count);
+    }
+
+    /**
+     * Allows the given non-terminals, forbidden by remove_non_terminals or
+     * new ones, numbered after the others. Any state connecting at least two
+     * terminals may now be improved through them, so only the trivial states
+     * (which only depend on the metric) are kept, unless keep_states tells
+     * none can be : true when the vertices were only left out by Steiner
+     * graph reductions that keep an optimal tree of every state among the
+     * vertices allowed then, as for the non-terminals of degree 1 or 2 and
+     * the blocks off the terminals.
+     */
+    template <typename Vertices>
+    void add_non_terminals(const Vertices &vertices, bool keep_states = false) {
+        std::vector<Vertex> added;
+        for (auto v : vertices) {
+            if (m_index.count(v)) continue;
+            m_index[v] = m_vertices.size() + added.size();
+            added.push_back(v);
+        }
+        if (!added.empty()) {
+            std::size_t n = m_vertices.size();
+            std::vector<int> number(n);
+            std::iota(number.begin(), number.end(), 0);
+            renumber(number, n + added.size());
+            std::copy(added.begin(), added.end(), m_vertices.begin() + n);
+        }
+
+        std::vector<int> allowed;
+        for (auto v : vertices) {
+            auto iter = m_index.find(v);
+            if (iter->second < m_terminals_count ||
+                m_allowed.test(iter->second)) continue;
+            m_allowed.set(iter->second);
+            m_non_terminals.push_back(iter->second);
+            allowed.push_back(iter->second);
+        }
+        if (allowed.empty() || m_start < 0) return;
+
+        measure_vertices(allowed);
+        if (!keep_states) drop_non_trivial_states();
+    }
+
+    /**
+     * Makes a terminal of a non-terminal, the last one. The memoized states stay optimal : they
+     * connect the same terminals, and the new terminal is usable on their way
+     * either way (as a terminal not to connect instead of a non-terminal). So
+     * the tables only double, the next solve() computing the states that
+     * connect the new terminal. If the vertex was forbidden, the states are
+     * dropped or kept as by add_non_terminals.
+     */
+    void add_terminal(Vertex v, bool keep_states = false) {
+        int t = m_terminals_count++; // its number once renumbered
+        assert((uint)m_terminals_count <= TerminalsLimit);
+        auto iter = m_index.find(v);
+        assert(iter != m_index.end() && iter->second >= t);
+        int id = iter->second;
+        bool allowed = m_allowed.test(id);
+
+        // it takes the number of the first non-terminal, which takes its own
+        if (id != t) {
+            std::vector<int> number(m_vertices.size());
+            std::iota(number.begin(), number.end(), 0);
+            std::swap(number[id], number[t]);
+            renumber(number, number.size());
+        }
+        if (allowed) {
+            m_allowed.reset(t);
+            m_non_terminals.erase(
+                std::find(m_non_terminals.begin(), m_non_terminals.end(), t));
+        }
+        if (m_start < 0) return;
+
+        // the old masks keep their rows, the new ones come after them
+        m_terminal_bit[t] = m_bit_vertex.size();
+        m_bit_vertex.push_back(t);
+        std::size_t cells = std::size_t(full_mask() + 1) * m_vertices.size();
+        m_cand_cost.resize(cells, -1);
+        m_cand_vertex.resize(cells, -1);
+        m_split_cost.resize(cells, -1);
+        m_split_mask.resize(cells, 0);
+
+        // an excluded vertex may now be used on the way, as for add_non_terminals
+        if (!allowed) {
+            measure_vertices(std::vector<int>{t});
+            if (!keep_states) drop_non_trivial_states();
+        }
+    }
+
+    /**
+     * Makes an allowed non-terminal of the terminal at the given position,
+     * the next terminals moving down. The states not connecting it stay
+     * optimal for the same reason as in add_terminal, so the tables only
+     * halve. Removing the start terminal drops the tables.
+     */
+    void remove_terminal(std::size_t position) {
+        int k = --m_terminals_count; // terminals left
+        int p = position;
+        assert(p <= k && m_vertices.size() > (std::size_t)k);
+        bool start_removed = p == m_start;
+        int bit = m_start >= 0 && !start_removed ? m_terminal_bit[p] : -1;
+
+        // the next terminals move down, it takes the last terminal number
+        std::vector<int> number(m_vertices.size());
+        std::iota(number.begin(), number.end(), 0);
+        for (int v = p + 1; v <= k; v++) number[v] = v - 1;
+        number[p] = k;
+        renumber(number, number.size());
+        m_allowed.set(k);
+        m_non_terminals.push_back(k);
+        if (m_start < 0) return;
+
+        if (start_removed) {
+            drop_tables();
+            return;
+        }
+
+        m_terminal_bit[k] = -1;
+        m_bit_vertex.erase(m_bit_vertex.begin() + bit);
+        for (int b = bit; b < (int)m_bit_vertex.size(); b++) {
+            m_terminal_bit[m_bit_vertex[b]] = b;
+        }
+
+        // Keeps the masks without the bit, in place : a kept row never
+        // moves up, so the rows still to read are not overwritten.
+        std::size_t n = m_vertices.size();
+        TerminalsMask low = (TerminalsMask(1) << bit) - 1;
+        for (TerminalsMask mask = 0; mask <= full_mask(); mask++) {
+            TerminalsMask old = (mask & low) | ((mask & ~low) << 1);
+            std::size_t from = cell(old, 0), to = cell(mask, 0);
+            for (std::size_t v = 0; v < n; v++) {
+                m_cand_cost[to + v] = m_cand_cost[from + v];
+                m_cand_vertex[to + v] = m_cand_vertex[from + v];
+                m_split_cost[to + v] = m_split_cost[from + v];
+                TerminalsMask split = m_split_mask[from + v];
+                m_split_mask[to + v] = (split & low) | ((split >> 1) & ~low);
+            }
+        }
+        std::size_t cells = std::size_t(full_mask() + 1) * n;
+        m_cand_cost.resize(cells);
+        m_cand_vertex.resize(cells);
+        m_split_cost.resize(cells);
+        m_split_mask.resize(cells);
+    }
+
+  private:
     /*
      * @brief Computes minimal cost of connecting given vertex and a set of
      * other vertices.
      * @param v vertex currently processed
      * @param mask vertices not yet processed has corresponding bits set to 1
      */
-    Dist connect_vertex(Vertex v, TerminalsBitSet remaining) {
-        if (remaining.none()) {
+    Dist connect_vertex(int v, TerminalsMask remaining) {
+        if (remaining == 0) {
             return 0;
         }
-        if (remaining.count() == 1) {
-            int k = smallest_bit(remaining);
-            Dist cost = m_cost_map(v, m_terminals[k]);
-            m_best_cand[code_state(v, remaining)] =
-                std::make_pair(cost, m_terminals[k]);
-            return cost;
+        std::size_t state = cell(remaining, v);
+        // Check in the table if already computed
+        if (m_cand_cost[state] >= 0) {
+            return m_cand_cost[state];
+        }
+        if (m_stopped || stop_requested()) {
+            return 0;
         }
-        // Check in the map if already computed
-        auto iter = m_best_cand.find(code_state(v, remaining));
-        if (iter != m_best_cand.end()) {
-            return iter->second.first;
+        if ((remaining & (remaining - 1)) == 0) {
+            int t = m_bit_vertex[smallest_bit(remaining)];
+            Dist cost = distance(v, t);
+            m_cand_cost[state] = cost;
+            m_cand_vertex[state] = t;
+            return cost;
         }
         Dist best = split_vertex(v, remaining);
-        Vertex cand = v;
+        int cand = v;
 
-        auto try_vertex = [&](Vertex w) {
+        auto try_vertex = [&](int w) {
                 Dist val = split_vertex(w, remaining);
-                val += m_cost_map(v, w);
+                val += distance(v, w);
                 if (best < 0 || val < best) {
                     best = val;
                     cand = w;
                 }
             };
-        for (Vertex w : m_non_terminals) {
+        for (int w : m_non_terminals) {
             try_vertex(w);
         }
-        for (auto w_with_id : m_elements_map) {
-            if (!remaining.test(w_with_id.second)) {
-                try_vertex(w_with_id.first);
+        for (int w = 0; w < m_terminals_count; w++) {
+            if (!in_remaining(w, remaining)) {
+                try_vertex(w);
             }
         }
-        for (auto vertex_and_terminal_id : m_elements_map) {
-            Vertex w = vertex_and_terminal_id.first;
-            int terminal_id = vertex_and_terminal_id.second;
-            if (!remaining.test(terminal_id)) continue;
-            remaining.reset(terminal_id);
-            Dist val = connect_vertex(w, remaining);
-            val += m_cost_map(v, w);
-            remaining.set(terminal_id);
+        for (int w = 0; w < m_terminals_count; w++) {
+            if (!in_remaining(w, remaining)) continue;
+            Dist val = connect_vertex(w, remaining ^ terminal_bit(w));
+            val += distance(v, w);
 
             if (best < 0 || val < best) {
                 best = val;
                 cand = w;
             }
         }
-        m_best_cand[code_state(v, remaining)] = std::make_pair(best, cand);
+        m_cand_cost[state] = best;
+        m_cand_vertex[state] = cand;
         return best;
     }
 
     /**
      * @brief Computes minimal cost by splitting the tree in two parts.
      */
-    Dist split_vertex(Vertex v, TerminalsBitSet remaining) {
-        if (remaining.count() < 2) {
+    Dist split_vertex(int v, TerminalsMask remaining) {
+        if (bit_count(remaining) < 2) {
             return 0;
         }
-        // Check in the map if already computed
-        auto iter = m_best_split.find(code_state(v, remaining));
-        if (iter != m_best_split.end()) {
-            return iter->second.first;
+        std::size_t state = cell(remaining, v);
+        // Check in the table if already computed
+        if (m_split_cost[state] >= 0) {
+            return m_split_cost[state];
+        }
+        if (m_stopped) {
+            return 0;
         }
         int k = smallest_bit(remaining) +
                 1; // optimalization, to avoid checking subset twice
-        std::pair<Dist, TerminalsBitSet> best =
+        std::pair<Dist, TerminalsMask> best =
             best_split(v, remaining, remaining, k);
-        m_best_split[code_state(v, remaining)] = best;
+        m_split_cost[state] = best.first;
+        m_split_mask[state] = best.second;
         return best.first;
     }
 
     /**
      * Generates all splits of given set of vertices and finds the best one.
      */
-    std::pair<Dist, TerminalsBitSet> best_split(const Vertex v,
-                                                const TerminalsBitSet remaining,
-                                                TerminalsBitSet subset, int k) {
-        if (k == (int)m_terminals.size()) {
-            TerminalsBitSet complement = remaining ^ subset;
-            if (!subset.none() && !complement.none()) {
+    std::pair<Dist, TerminalsMask> best_split(const int v,
+                                              const TerminalsMask remaining,
+                                              TerminalsMask subset, int k) {
+        if (k == (int)m_bit_vertex.size()) {
+            TerminalsMask complement = remaining ^ subset;
+            if (subset != 0 && complement != 0) {
                 Dist val =
                     connect_vertex(v, subset) + connect_vertex(v, complement);
-                return make_pair(val, subset);
+                return std::make_pair(val, subset);
             } else {
-                return std::make_pair(-1, NULL);
+                return std::make_pair(Dist(-1), TerminalsMask(0));
             }
         } else {
-            std::pair<Dist, TerminalsBitSet> ret1, ret2;
+            std::pair<Dist, TerminalsMask> ret1, ret2;
             ret1 = best_split(v, remaining, subset, k + 1);
-            if (remaining.test(k)) {
-                subset.flip(k);
+            if (remaining & (TerminalsMask(1) << k)) {
+                subset ^= TerminalsMask(1) << k;
                 ret2 = best_split(v, remaining, subset, k + 1);
                 if (ret1.first < 0 || ret1.first > ret2.first) {
                     ret1 = ret2;
@@ -200,26 +590,206 @@ class dreyfus_wagner {
         }
     }
 
+    /**
+     * Fills the missing states bottom-up : the masks of c terminals only
+     * depend on the masks of less than c terminals, and on the split states
+     * of the same mask, computed first. Only the states connect_vertex can
+     * reach are filled : no removed non-terminal, no terminal of the mask.
+     *
+     * The states of a layer are independent from each other, so with a pool
+     * each layer is cut in (mask, block of vertices) items run in parallel,
+     * once for the split states and once for the connect states.
+     */
+    void fill_tables() {
+        TerminalsMask full = full_mask();
+        bool parallel = m_pool && m_pool->get_threads_count() > 1;
+
+        std::vector<int> vertices(m_non_terminals);
+        for (int t = 0; t < m_terminals_count; t++) {
+            vertices.push_back(t);
+        }
+        std::vector<TerminalsMask> layer;
+
+        for (int count = 1; count <= (int)m_bit_vertex.size(); count++) {
+            // masks of 'count' bits, in increasing order (Gosper's hack)
+            TerminalsMask mask = (TerminalsMask(1) << count) - 1;
+            if (stop_requested()) return;
+            if (parallel) {
+                layer.clear();
+                for (; mask <= full; mask = next_same_count(mask)) {
+                    layer.push_back(mask);
+                    if (mask == full) break;
+                }
+                if (count >= 2) fill_layer(layer, vertices, true);
+                if (m_stopped) return;
+                if (layer.back() != full) fill_layer(layer, vertices, false);
+                else if (m_cand_cost[cell(full, m_start)] < 0) fill_connect(m_start, full);
+                if (m_stopped) return;
+                continue;
+            }
+
+            for (; mask <= full; mask = next_same_count(mask)) {
+                if (stop_requested()) return;
+                std::size_t row = cell(mask, 0);
+                if (count >= 2) {
+                    for (int v : vertices) {
+                        if (!in_remaining(v, mask) && m_split_cost[row + v] < 0) {
+                            fill_split(v, mask);
+                        }
+                    }
+                }
+                // the last layer only serves the start terminal
+                if (mask == full) {
+                    if (m_cand_cost[row + m_start] < 0) fill_connect(m_start, mask);
+                    break;
+                }
+                for (int v : vertices) {
+                    if (!in_remaining(v, mask) && m_cand_cost[row + v] < 0) {
+                        fill_connect(v, mask);
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Fills the split (or connect) states of a layer on the pool. Each mask
+     * checks the stop condition once, its other items skip it once it held.
+     */
+    void fill_layer(const std::vector<TerminalsMask> &layer,
+                    const std::vector<int> &vertices, bool split) {
+        const std::size_t block_size = 64;
+        std::size_t blocks = (vertices.size() + block_size - 1) / block_size;
+        std::atomic<bool> stopped(false);
+
+        m_pool->parallel_for(layer.size() * blocks, [&](std::size_t item) {
+            if (stopped.load(std::memory_order_relaxed)) return;
+            if (item % blocks == 0 && m_stop && m_stop()) {
+                stopped = true;
+                return;
+            }
+            TerminalsMask mask = layer[item / blocks];
+            std::size_t row = cell(mask, 0);
+            std::size_t begin = (item % blocks) * block_size;
+            std::size_t end = std::min(begin + block_size, vertices.size());
+
+            for (std::size_t i = begin; i < end; i++) {
+                int v = vertices[i];
+                if (in_remaining(v, mask)) continue;
+                if (split && m_split_cost[row + v] < 0) {
+                    fill_split(v, mask);
+                } else if (!split && m_cand_cost[row + v] < 0) {
+                    fill_connect(v, mask);
+                }
+            }
+        });
+        if (stopped) m_stopped = true;
+    }
+
+    /**
+     * Next mask having the same number of bits set.
+     */
+    static TerminalsMask next_same_count(TerminalsMask mask) {
+        TerminalsMask low = mask & (~mask + 1);
+        TerminalsMask ripple = mask + low;
+        return (((ripple ^ mask) >> 2) / low) | ripple;
+    }
+
+    /**
+     * Same as connect_vertex, reading the smaller states from the tables.
+     */
+    void fill_connect(int v, TerminalsMask remaining) {
+        std::size_t state = cell(remaining, v);
+        if ((remaining & (remaining - 1)) == 0) {
+            int t = m_bit_vertex[smallest_bit(remaining)];
+            m_cand_cost[state] = distance(v, t);
+            m_cand_vertex[state] = t;
+            return;
+        }
+        std::size_t row = cell(remaining, 0);
+        Dist best = m_split_cost[row + v];
+        int cand = v;
+
+        auto try_vertex = [&](int w) {
+                Dist val = m_split_cost[row + w] + distance(v, w);
+                if (best < 0 || val < best) {
+                    best = val;
+                    cand = w;
+                }
+            };
+        for (int w : m_non_terminals) {
+            try_vertex(w);
+        }
+        for (int w = 0; w < m_terminals_count; w++) {
+            if (!in_remaining(w, remaining)) {
+                try_vertex(w);
+            }
+        }
+        for (int w = 0; w < m_terminals_count; w++) {
+            if (!in_remaining(w, remaining)) continue;
+            Dist val = m_cand_cost[cell(remaining ^ terminal_bit(w), w)] +
+                       distance(v, w);
+            if (best < 0 || val < best) {
+                best = val;
+                cand = w;
+            }
+        }
+        m_cand_cost[state] = best;
+        m_cand_vertex[state] = cand;
+    }
+
+    /**
+     * Same as split_vertex, enumerating the submasks directly. best_split
+     * keeps the first minimum of its depth-first order, where lower bits are
+     * kept before being cleared : on equal costs, the split having the lowest
+     * differing bit set wins.
+     */
+    void fill_split(int v, TerminalsMask remaining) {
+        TerminalsMask low = remaining & (~remaining + 1);
+        TerminalsMask rest = remaining ^ low;
+        Dist best = -1;
+        TerminalsMask best_subset = 0;
+
+        // every split once : the lowest terminal goes to 'subset'
+        for (TerminalsMask sub = (rest - 1) & rest;; sub = (sub - 1) & rest) {
+            TerminalsMask subset = low | sub;
+            Dist val = m_cand_cost[cell(subset, v)] +
+                       m_cand_cost[cell(remaining ^ subset, v)];
+            if (best < 0 || val < best ||
+                (val == best && first_in_split_order(subset, best_subset))) {
+                best = val;
+                best_subset = subset;
+            }
+            if (sub == 0) break;
+        }
+        std::size_t state = cell(remaining, v);
+        m_split_cost[state] = best;
+        m_split_mask[state] = best_subset;
+    }
+
+    static bool first_in_split_order(TerminalsMask a, TerminalsMask b) {
+        TerminalsMask diff = a ^ b;
+        return (a & diff & (~diff + 1)) != 0;
+    }
+
     /**
      * Retrieves the path of the optimal solution returned by connect_vertex
      * method.
      */
-    void retrieve_solution_connect(Vertex v, TerminalsBitSet remaining) {
-        if (remaining.none()) return;
-        Vertex next = m_best_cand.at(code_state(v, remaining)).second;
+    void retrieve_solution_connect(int v, TerminalsMask remaining) {
+        if (remaining == 0) return;
+        int next = m_cand_vertex[cell(remaining, v)];
 
-        auto terminal_id_iter = m_elements_map.find(next);
         if (v == next) { // called wagner directly from dreyfus
             retrieve_solution_split(next, remaining);
-        } else if (terminal_id_iter == m_elements_map.end() // nonterminal
-                || !remaining.test(terminal_id_iter->second)) { // terminal not in remaining
+        } else if (!in_remaining(next, remaining)) { // nonterminal, or
+                                                     // terminal not in remaining
             add_vertex_to_graph(next);
             add_edge_to_graph(v, next);
             retrieve_solution_split(next, remaining);
         } else { // terminal
             add_edge_to_graph(v, next);
-            remaining.flip(terminal_id_iter->second);
-            retrieve_solution_connect(next, remaining);
+            retrieve_solution_connect(next, remaining ^ terminal_bit(next));
         }
     }
 
@@ -227,76 +797,355 @@ class dreyfus_wagner {
      * Retrieves the path of the optimal solution returned by split_vertex
      * method.
      */
-    void retrieve_solution_split(Vertex v, TerminalsBitSet remaining) {
-        if (remaining.none()) return;
-        TerminalsBitSet split =
-            m_best_split.at(code_state(v, remaining)).second;
+    void retrieve_solution_split(int v, TerminalsMask remaining) {
+        if (bit_count(remaining) < 2) return;
+        TerminalsMask split = m_split_mask[cell(remaining, v)];
         retrieve_solution_connect(v, split);
         retrieve_solution_connect(v, remaining ^ split);
     }
 
     /**
-     * Codes current state to the structure that fits as the map key.
+     * Tells whether the memoized solution of connect_vertex goes through one
+     * of the removed vertices, following the same path as
+     * retrieve_solution_connect.
+     */
+    bool connect_uses(int v, TerminalsMask remaining,
+                      const std::vector<char> &removed,
+                      std::vector<char> &connect_marks,
+                      std::vector<char> &split_marks) {
+        if (removed[v]) return true;
+        if (remaining == 0) return false;
+
+        std::size_t state = cell(remaining, v);
+        if (connect_marks[state] != unmarked) {
+            return connect_marks[state] == marked_used;
+        }
+
+        bool uses;
+        int next = m_cand_vertex[state];
+        if (v == next) {
+            uses = split_uses(next, remaining, removed, connect_marks, split_marks);
+        } else if (!in_remaining(next, remaining)) {
+            uses = removed[next] ||
+                   split_uses(next, remaining, removed, connect_marks, split_marks);
+        } else {
+            uses = connect_uses(next, remaining ^ terminal_bit(next), removed,
+                                connect_marks, split_marks);
+        }
+        connect_marks[state] = uses ? marked_used : marked_unused;
+        return uses;
+    }
+
+    /**
+     * Tells whether the memoized solution of split_vertex goes through one
+     * of the removed vertices.
+     */
+    bool split_uses(int v, TerminalsMask remaining,
+                    const std::vector<char> &removed,
+                    std::vector<char> &connect_marks,
+                    std::vector<char> &split_marks) {
+        if (removed[v]) return true;
+        if (bit_count(remaining) < 2) return false;
+
+        std::size_t state = cell(remaining, v);
+        if (split_marks[state] != unmarked) {
+            return split_marks[state] == marked_used;
+        }
+
+        TerminalsMask split = m_split_mask[state];
+        bool uses = connect_uses(v, split, removed, connect_marks, split_marks) ||
+                    connect_uses(v, remaining ^ split, removed, connect_marks, split_marks);
+        split_marks[state] = uses ? marked_used : marked_unused;
+        return uses;
+    }
+
+    /**
+     * Only keeps the trivial states, which only depend on the metric.
+     */
+    void drop_non_trivial_states() {
+        int n = m_vertices.size();
+        for (TerminalsMask mask = 0; mask <= full_mask(); mask++) {
+            int count = bit_count(mask);
+            if (count >= 2) {
+                std::fill_n(m_cand_cost.begin() + cell(mask, 0), n, -1);
+            }
+            if (count >= 3) {
+                std::fill_n(m_split_cost.begin() + cell(mask, 0), n, -1);
+            }
+        }
+    }
+
+    /**
+     * Gives the vertices new numbers below count, number[v] being the new
+     * number of v or -1 to drop it, moving the distances and the tables
+     * columns along. The numbers of no vertex are left for the caller to
+     * fill, unmeasured and with empty columns.
      */
-    State code_state(Vertex v, TerminalsBitSet remaining) {
-        // TODO: can be optimized
-        return std::make_pair(v, remaining);
+    void renumber(const std::vector<int> &number, std::size_t count) {
+        std::size_t n = m_vertices.size();
+        std::vector<Vertex> vertices(count);
+        boost::dynamic_bitset<> allowed(count);
+        for (std::size_t v = 0; v < n; v++) {
+            if (number[v] < 0) {
+                m_index.erase(m_vertices[v]);
+                continue;
+            }
+            vertices[number[v]] = m_vertices[v];
+            m_index[m_vertices[v]] = number[v];
+            if (m_allowed.test(v)) allowed.set(number[v]);
+        }
+        m_vertices.swap(vertices);
+        m_allowed.swap(allowed);
+        for (auto &w : m_non_terminals) w = number[w];
+
+        // copies may still read the old distances
+        if (m_distances) {
+            auto distances = std::make_shared<std::vector<Dist>>(count * count, Dist(-1));
+            for (std::size_t u = 0; u < n; u++) {
+                if (number[u] < 0) continue;
+                for (std::size_t w = 0; w < n; w++) {
+                    if (number[w] < 0) continue;
+                    (*distances)[number[u] * count + number[w]] = (*m_distances)[u * n + w];
+                }
+            }
+            m_distances = std::move(distances);
+        }
+        if (m_start < 0) return;
+
+        m_start = number[m_start];
+        std::vector<int> terminal_bit(count, -1);
+        for (std::size_t v = 0; v < n; v++) {
+            if (number[v] >= 0) terminal_bit[number[v]] = m_terminal_bit[v];
+        }
+        m_terminal_bit.swap(terminal_bit);
+        for (auto &t : m_bit_vertex) t = number[t];
+
+        renumber_columns(m_cand_cost, number, count, Dist(-1));
+        renumber_columns(m_cand_vertex, number, count, -1);
+        renumber_columns(m_split_cost, number, count, Dist(-1));
+        renumber_columns(m_split_mask, number, count, TerminalsMask(0));
+        // the states choosing a dropped vertex went through it : invalidated
+        for (auto &cand : m_cand_vertex) {
+            if (cand >= 0) cand = number[cand];
+        }
     }
 
     /**
-     * Hash function for State, used in unordered_maps.
+     * Moves each row's columns to their new numbers, count per row, the
+     * columns of no vertex being empty. A row is buffered then written over
+     * rows read already : forwards when the rows shrink, backwards otherwise.
      */
-    struct state_hash {
-        std::size_t operator()(const State &k) const {
-            return boost::hash<Vertex>()(k.first) ^
-                   (std::hash<TerminalsBitSet>()(k.second) << 1);
+    template <typename Table>
+    void renumber_columns(Table &table, const std::vector<int> &number,
+                          std::size_t count,
+                          typename Table::value_type empty) const {
+        std::size_t n = number.size();
+        std::size_t rows = table.size() / n;
+        Table row(count);
+        auto move_row = [&](std::size_t r) {
+            std::fill(row.begin(), row.end(), empty);
+            for (std::size_t v = 0; v < n; v++) {
+                if (number[v] >= 0) row[number[v]] = table[r * n + v];
+            }
+            std::copy(row.begin(), row.end(), table.begin() + r * count);
+        };
+        if (count <= n) {
+            for (std::size_t r = 0; r < rows; r++) move_row(r);
+            table.resize(rows * count);
+        } else {
+            table.resize(rows * count);
+            for (std::size_t r = rows; r-- > 0;) move_row(r);
         }
-    };
+    }
+
+    /**
+     * Numbers the terminals other than 'start' and allocates the tables.
+     */
+    void init_tables(int start) {
+        m_start = start;
+        m_terminal_bit.assign(m_vertices.size(), -1);
+        m_bit_vertex.clear();
+        for (int t = 0; t < m_terminals_count; t++) {
+            if (t != start) {
+                m_terminal_bit[t] = m_bit_vertex.size();
+                m_bit_vertex.push_back(t);
+            }
+        }
+
+        std::vector<int> vertices(m_non_terminals);
+        for (int t = 0; t < m_terminals_count; t++) vertices.push_back(t);
+        measure_vertices(vertices);
+
+        std::size_t cells = std::size_t(full_mask() + 1) * m_vertices.size();
+        m_cand_cost.assign(cells, -1);
+        m_cand_vertex.assign(cells, -1);
+        m_split_cost.assign(cells, -1);
+        m_split_mask.assign(cells, 0);
+    }
+
+    /**
+     * Forgets the tables, as if solve() was never called.
+     */
+    void drop_tables() {
+        m_start = -1;
+        std::vector<Dist>().swap(m_cand_cost);
+        std::vector<int>().swap(m_cand_vertex);
+        std::vector<Dist>().swap(m_split_cost);
+        std::vector<TerminalsMask>().swap(m_split_mask);
+    }
+
+    /**
+     * Checks the stop condition, remembering for the rest of solve() that it
+     * held.
+     */
+    bool stop_requested() {
+        if (!m_stopped && m_stop && m_stop()) m_stopped = true;
+        return m_stopped;
+    }
+
+    /**
+     * Copies the metric between the given vertices and the ones measured
+     * already, one row at a time : the recursion then reads a flat table,
+     * and a metric computing its rows on demand is asked each row once. Only
+     * the terminals and the allowed non-terminals are measured, the others
+     * are never read : their distances stay negative until they are allowed.
+     */
+    void measure_vertices(const std::vector<int> &vertices) {
+        std::size_t n = m_vertices.size();
+        std::vector<int> measured, unmeasured;
+        for (std::size_t v = 0; v < n; v++) {
+            if (m_distances && (*m_distances)[v * n + v] >= 0) measured.push_back(v);
+        }
+        for (int u : vertices) {
+            if (!m_distances || (*m_distances)[u * n + u] < 0) unmeasured.push_back(u);
+        }
+        if (unmeasured.empty()) return;
+
+        // copies may still read the old distances
+        auto distances = m_distances ?
+            std::make_shared<std::vector<Dist>>(*m_distances) :
+            std::make_shared<std::vector<Dist>>(n * n, Dist(-1));
+        for (int u : unmeasured) {
+            measured.push_back(u);
+            for (int w : measured) {
+                (*distances)[u * n + w] = (*m_cost_map)(m_vertices[u], m_vertices[w]);
+                (*distances)[w * n + u] = (*m_cost_map)(m_vertices[w], m_vertices[u]);
+            }
+        }
+        m_distances = std::move(distances);
+    }
+
+    /**
+     * Gives its number to a vertex, the first time it is seen.
+     */
+    int index_vertex(Vertex v) {
+        auto iter = m_index.find(v);
+        if (iter != m_index.end()) return iter->second;
+        m_index[v] = m_vertices.size();
+        m_vertices.push_back(v);
+        return m_vertices.size() - 1;
+    }
+
+    /**
+     * Position of a state in the tables.
+     */
+    std::size_t cell(TerminalsMask remaining, int v) const {
+        return std::size_t(remaining) * m_vertices.size() + v;
+    }
+
+    /**
+     * Mask of all the terminals other than 'start'.
+     */
+    TerminalsMask full_mask() const {
+        return (TerminalsMask(1) << m_bit_vertex.size()) - 1;
+    }
+
+    /**
+     * Bit of a terminal in the masks.
+     */
+    TerminalsMask terminal_bit(int t) const {
+        return TerminalsMask(1) << m_terminal_bit[t];
+    }
+
+    /**
+     * Tells if the given vertex is a terminal still to be connected.
+     */
+    bool in_remaining(int v, TerminalsMask remaining) const {
+        return m_terminal_bit[v] >= 0 && (remaining & terminal_bit(v));
+    }
+
+    Dist distance(int u, int w) const {
+        return (*m_distances)[std::size_t(u) * m_vertices.size() + w];
+    }
 
     /**
      * Adds the edge to the solution.
      */
-    void add_edge_to_graph(Vertex u, Vertex w) {
-        Edge e = std::make_pair(u, w);
+    void add_edge_to_graph(int u, int w) {
+        Edge e = std::make_pair(m_vertices[u], m_vertices[w]);
         m_edges.push_back(e);
     }
 
     /**
-     * Adds Steiner vertex to the solution.
+     * Adds Steiner vertex to the solution, terminals branched from again are
+     * not Steiner vertices.
      */
-    void add_vertex_to_graph(Vertex v) { m_steiner_elements.insert(v); }
+    void add_vertex_to_graph(int v) {
+        if (v >= m_terminals_count) m_steiner_elements.insert(m_vertices[v]);
+    }
 
     /**
      * Finds the index of the first nonempty bit in given mask.
      */
-    int smallest_bit(TerminalsBitSet mask) {
+    static int smallest_bit(TerminalsMask mask) {
         int k = 0;
-        while (!mask.test(k)) ++k;
+        while (!(mask & (TerminalsMask(1) << k))) ++k;
         return k;
     }
 
-    const Metric &m_cost_map;            // stores the cost for each edge
-    const Terminals &m_terminals;        // terminals to be connected
-	/*const*/ NonTerminals &m_non_terminals; // list of all non-terminals
+    static int bit_count(TerminalsMask mask) {
+        return std::bitset<sizeof(TerminalsMask) * 8>(mask).count();
+    }
+
+    static constexpr char unmarked = 0, marked_unused = 1, marked_used = 2;
+
+    const Metric *m_cost_map;            // stores the cost for each edge
+    int m_terminals_count;               // terminals to be connected,
+                                         // numbered first
+    dreyfus_wagner_engine m_engine;      // how solve() fills the tables
+    std::shared_ptr<data_structures::work_stealing_pool> m_pool; // threads
+                                         // of the iterative engine, if any
+    std::function<bool()> m_stop;        // checked while filling the tables,
+                                         // may be empty
+    bool m_stopped;                      // the stop condition held during
+                                         // the last solve()
+    std::vector<int> m_non_terminals;    // list of all non-terminals
+    boost::dynamic_bitset<> m_allowed;   // same, as a set of numbers
 
     Dist m_cost;                         // cost of optimal Steiner Tree
     steiner_elements m_steiner_elements; // non-terminals selected for spanning
                                          // tree
     std::vector<Edge> m_edges;           // edges spanning the component
 
-    std::unordered_map<Vertex, int, boost::hash<Vertex>> m_elements_map; // maps Vertex to position
-                                                    // in m_terminals vector
-    using StateV = std::pair<Dist, Vertex>;
-    using StateBM = std::pair<Dist, TerminalsBitSet>;
-    std::unordered_map<State, StateV, state_hash> m_best_cand; // stores result
-                                                               // of dreyfus
-                                                               // method for
-                                                               // given state
-    std::unordered_map<State, StateBM, state_hash> m_best_split; // stores
-                                                                 // result of
-                                                                 // wagner
-                                                                 // method for
-																 // given state
+    std::unordered_map<Vertex, int, boost::hash<Vertex>> m_index; // maps Vertex to
+                                                  // its number, only used
+                                                  // out of the recursion
+    std::vector<Vertex> m_vertices;      // maps number to Vertex, terminals
+                                         // first
+    int m_start;                         // start terminal the tables are
+                                         // built for, -1 if none yet
+    std::vector<int> m_terminal_bit;     // maps number to bit in the masks,
+                                         // -1 if not a remaining terminal
+    std::vector<int> m_bit_vertex;       // maps bit in the masks to number
+    std::shared_ptr<const std::vector<Dist>> m_distances; // metric between
+                                         // numbers, shared by the copies
+
+    std::vector<Dist> m_cand_cost;       // cost of dreyfus method for
+                                         // given state
+    std::vector<int> m_cand_vertex;      // vertex chosen by dreyfus method
+    std::vector<Dist> m_split_cost;      // cost of wagner method for
+                                         // given state
+    std::vector<TerminalsMask> m_split_mask; // split chosen by wagner method
 };
 
 /**
@@ -309,7 +1158,7 @@ class dreyfus_wagner {
 template <unsigned int TerminalsLimit = 32, typename Metric, typename Terminals, typename NonTerminals>
 dreyfus_wagner<Metric, Terminals, NonTerminals, TerminalsLimit>
 make_dreyfus_wagner(const Metric &metric, const Terminals &terminals,
-					/*const*/ NonTerminals &non_terminals) {
+                    const NonTerminals &non_terminals) {
     return dreyfus_wagner<Metric, Terminals, NonTerminals, TerminalsLimit>(
         metric, terminals, non_terminals);
 }
@@ -132,8 +132,10 @@ equals(GQB_JOIN_SOLVER, "y"){
 
 	#message("GQB join solver!")
 	DEFINES += "GRAPHICAL_QUERY_BUILDER_JOIN_SOLVER"
-	HEADERS += src/graphicalquerybuilderjoinsolver.h
-	SOURCES += src/graphicalquerybuilderjoinsolver.cpp
+	HEADERS += src/graphicalquerybuilderjoinsolver.h \
+			   src/graphicalquerybuilderpathsmodel.h
+	SOURCES += src/graphicalquerybuilderjoinsolver.cpp \
+			   src/graphicalquerybuilderpathsmodel.cpp
 	INCLUDEPATH += $$absolute_path($$PWD/paal/include) \
 								 $$absolute_path($$PWD/paal/boost)
 	DEPENDPATH += $$absolute_path($$PWD/paal/include) \
@@ -0,0 +1,370 @@
+//=======================================================================
+// Copyright (c)
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//=======================================================================
+/**
+ * @file k_best_dreyfus_wagner.hpp
+ * @brief Enumerates Steiner Trees by non-decreasing cost.
+ * @version 1.0
+ */
+#ifndef PAAL_K_BEST_DREYFUS_WAGNER_HPP
+#define PAAL_K_BEST_DREYFUS_WAGNER_HPP
+
+#include "paal/steiner_tree/dreyfus_wagner.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <vector>
+
+namespace paal {
+
+/**
+ * Ranked enumeration of Steiner Trees, using Lawler's partitioning of the
+ * solution space on top of the Dreyfus-Wagner algorithm.
+ *
+ * Trees are told apart by their Steiner vertices. A sub-problem is a set of
+ * excluded non-terminals and a set of included ones, its solution being the
+ * optimal tree avoiding the former and going through the latter, which are
+ * promoted to terminals. When a sub-problem is popped, with s_1 < ... < s_m
+ * the Steiner vertices of its tree not included yet, child i excludes s_i and
+ * includes s_1..s_{i-1}. The children are disjoint, and hold every tree of
+ * the sub-problem missing one of s_1..s_m : each tree is found once,
+ * sub-problems are popped by cost so trees come out in non-decreasing cost
+ * order, and each extra tree costs at most m Dreyfus-Wagner runs. The trees
+ * going through s_1..s_m and more non-terminals are not enumerated : they
+ * only add Steiner vertices to a tree at most as expensive.
+ *
+ * Each run is an incremental re-solve of the first run's tables : a child
+ * starts from its parent's tables, minus the states going through its new
+ * excluded vertex, plus the states connecting its new included ones.
+ *
+ * The children of a sub-problem are independent, so with several threads
+ * they are solved concurrently, each on its own copy of the tables. They are
+ * queued in Steiner vertex order once all are solved, so the enumeration
+ * does not depend on the threads timing.
+ *
+ * The first run's tables outlive the enumeration : after a terminal or
+ * non-terminals are added or removed, the next enumeration extends or
+ * shrinks them.
+ */
+template <typename Metric, typename Terminals, typename NonTerminals,
+		  unsigned int TerminalsLimit = 32>
+class k_best_dreyfus_wagner {
+  public:
+    using DW = dreyfus_wagner<Metric, Terminals, NonTerminals, TerminalsLimit>;
+    using Vertex = typename DW::Vertex;
+    using Dist = typename DW::Dist;
+    using Edge = typename DW::Edge;
+    using VertexSet = std::vector<Vertex>; // kept sorted
+
+    /**
+     * Constructor, the trees will only use the given non-terminals.
+     */
+    k_best_dreyfus_wagner(const Metric &cost_map, const Terminals &term,
+                          const NonTerminals &non_terminals)
+        : m_root(cost_map, term, non_terminals), m_started(false), m_solved(0),
+          m_terminals_limit(TerminalsLimit) {}
+
+    /**
+     * Selects how the Dreyfus-Wagner tables are filled, before the first
+     * call to next().
+     */
+    void set_engine(dreyfus_wagner_engine engine) { m_root.set_engine(engine); }
+
+    /**
+     * Number of threads filling each Dreyfus-Wagner run's tables, before the
+     * first call to next().
+     */
+    void set_threads_count(unsigned threads_count) {
+        m_root.set_threads_count(threads_count);
+    }
+
+    /**
+     * Caps the terminals of a sub-problem, included vertices counted, so that
+     * its tables fit in memory. The children over it are not solved, and the
+     * trees only they hold are not enumerated.
+     */
+    void set_terminals_limit(std::size_t terminals_limit) {
+        m_terminals_limit = std::min<std::size_t>(terminals_limit, TerminalsLimit);
+    }
+
+    /**
+     * Measures the vertices added from now on with the given metric, see
+     * dreyfus_wagner::set_cost_map.
+     */
+    void set_cost_map(const Metric &cost_map) { m_root.set_cost_map(cost_map); }
+
+    /**
+     * Sets a condition checked before and during each Dreyfus-Wagner run, see
+     * dreyfus_wagner::set_stop_condition : once it holds, next() gives up and
+     * returns false. An interrupted first run drops the first run's tables.
+     */
+    void set_stop_condition(std::function<bool()> stop) {
+        m_root.set_stop_condition(stop);
+        m_stop = std::move(stop);
+    }
+
+    /**
+     * Restarts the enumeration from the first tree, whose tables are kept.
+     */
+    void restart() {
+        m_started = false;
+        m_solved = 0;
+        m_queue = decltype(m_queue)();
+    }
+
+    /**
+     * Makes a terminal of a non-terminal, see dreyfus_wagner::add_terminal.
+     * The enumeration restarts, the first run only computing the states
+     * connecting the new terminal.
+     */
+    void add_terminal(Vertex v, bool keep_states = false) {
+        m_root.add_terminal(v, keep_states);
+        restart();
+    }
+
+    /**
+     * Makes a non-terminal of the terminal at the given position, see
+     * dreyfus_wagner::remove_terminal. The enumeration restarts.
+     */
+    void remove_terminal(std::size_t position) {
+        m_root.remove_terminal(position);
+        restart();
+    }
+
+    /**
+     * Forbids non-terminals to every tree, see
+     * dreyfus_wagner::remove_non_terminals. The enumeration restarts.
+     */
+    template <typename Vertices>
+    void remove_non_terminals(const Vertices &vertices) {
+        m_root.remove_non_terminals(vertices);
+        restart();
+    }
+
+    /**
+     * Forgets non-terminals, their columns of the tables going with them, see
+     * dreyfus_wagner::erase_non_terminals. The enumeration restarts.
+     */
+    template <typename Vertices>
+    void erase_non_terminals(const Vertices &vertices) {
+        m_root.erase_non_terminals(vertices);
+        restart();
+    }
+
+    /**
+     * Allows non-terminals, forbidden by remove_non_terminals or new ones, see
+     * dreyfus_wagner::add_non_terminals. The enumeration restarts.
+     */
+    template <typename Vertices>
+    void add_non_terminals(const Vertices &vertices, bool keep_states = false) {
+        m_root.add_non_terminals(vertices, keep_states);
+        restart();
+    }
+
+    /**
+     * Computes the next cheapest Steiner Tree.
+     * @return false when all the trees were enumerated.
+     */
+    bool next() {
+        if (stopped()) return false;
+
+        if (!m_started) {
+            if (!m_root.solve()) return false;
+            m_started = true;
+            m_solved++;
+            push(m_root, VertexSet(), VertexSet());
+        } else {
+            branch(m_current);
+        }
+
+        if (m_queue.empty() || stopped()) return false;
+        m_current = m_queue.top();
+        m_queue.pop();
+        return true;
+    }
+
+    /**
+     * Gets the cost of the current tree.
+     */
+    Dist get_cost() const { return m_current.cost; }
+
+    /**
+     * Gets the edges of the current tree.
+     */
+    const std::vector<Edge> &get_edges() const { return m_current.edges; }
+
+    /**
+     * Gets the Steiner vertices of the current tree, sorted.
+     */
+    const VertexSet &get_steiner_elements() const {
+        return m_current.steiners;
+    }
+
+    /**
+     * Gets the number of Dreyfus-Wagner runs done so far.
+     */
+    long long get_solved_count() const { return m_solved; }
+
+    /**
+     * Gets the number of sub-problems waiting in the queue.
+     */
+    std::size_t get_pending_count() const { return m_queue.size(); }
+
+    /**
+     * Gets a bound on the peak memory used by the Dreyfus-Wagner tables, in
+     * bytes : the first run's tables, plus a parent copy and one child copy
+     * per thread while branching, each of at most the terminals limit, and
+     * the distances they all share.
+     */
+    std::size_t get_memory_usage() const {
+        std::size_t threads_count =
+            m_root.get_pool() ? m_root.get_pool()->get_threads_count() : 1;
+        return memory_usage(std::max(m_root.get_terminals_count(), m_terminals_limit),
+                            m_root.get_vertices_count(), threads_count);
+    }
+
+    /**
+     * Same as get_memory_usage, for sub-problems of at most the given number
+     * of terminals, without building the tables : saturates to the largest
+     * std::size_t.
+     */
+    static std::size_t memory_usage(std::size_t terminals_count,
+                                    std::size_t vertices_count,
+                                    std::size_t threads_count) {
+        const std::size_t max = std::numeric_limits<std::size_t>::max();
+        std::size_t run = DW::tables_memory_usage(terminals_count, vertices_count);
+        std::size_t distances = DW::distances_memory_usage(vertices_count);
+        std::size_t copies = 2 + threads_count;
+        if (run > max / copies || copies * run > max - distances) {
+            return max;
+        }
+        return copies * run + distances;
+    }
+
+  private:
+    struct sub_problem {
+        Dist cost;
+        long long order; // tie-breaker, keeps the enumeration deterministic
+        VertexSet excluded;
+        VertexSet included; // promoted to terminals
+        VertexSet steiners; // included ones too
+        std::vector<Edge> edges;
+    };
+
+    struct sub_problem_greater {
+        bool operator()(const sub_problem &a, const sub_problem &b) const {
+            return a.cost > b.cost || (a.cost == b.cost && a.order > b.order);
+        }
+    };
+
+    /**
+     * Queues the solved sub-problem avoiding the excluded vertices and going
+     * through the included ones.
+     */
+    void push(const DW &dw, VertexSet excluded, VertexSet included) {
+        sub_problem problem;
+        problem.cost = dw.get_cost();
+        problem.order = m_solved;
+        problem.excluded = std::move(excluded);
+        problem.steiners.assign(dw.get_steiner_elements().begin(),
+                                dw.get_steiner_elements().end());
+        problem.steiners.insert(problem.steiners.end(), included.begin(),
+                                included.end());
+        std::sort(problem.steiners.begin(), problem.steiners.end());
+        problem.included = std::move(included);
+        problem.edges = dw.get_edges();
+        m_queue.push(std::move(problem));
+    }
+
+    /**
+     * Partitions the remaining solutions of a sub-problem.
+     */
+    void branch(const sub_problem &problem) {
+        VertexSet free;
+        std::set_difference(problem.steiners.begin(), problem.steiners.end(),
+                            problem.included.begin(), problem.included.end(),
+                            std::back_inserter(free));
+        // child i promotes i vertices more than its parent
+        std::size_t terminals_count =
+            m_root.get_terminals_count() + problem.included.size();
+        std::size_t children_count = 0;
+        while (children_count < free.size() &&
+               terminals_count + children_count <= m_terminals_limit) {
+            children_count++;
+        }
+        if (children_count == 0 || stopped()) return;
+
+        // Rebuild the parent's tables only once, for all its children
+        DW parent = m_root;
+        parent.remove_non_terminals(problem.excluded);
+        for (auto v : problem.included) parent.add_terminal(v);
+        if (!parent.solve()) return;
+
+        auto pool = m_root.get_pool();
+        std::vector<std::unique_ptr<DW>> solved(children_count);
+        auto solve_child = [&](std::size_t i) {
+            if (stopped()) return;
+            std::unique_ptr<DW> child(new DW(parent));
+            // the pool runs the children, each child runs alone
+            if (pool) child->set_pool(nullptr);
+            child->remove_non_terminals(VertexSet{free[i]});
+            for (std::size_t j = 0; j < i; j++) child->add_terminal(free[j]);
+            if (child->solve()) solved[i] = std::move(child);
+        };
+        if (pool && children_count > 1) {
+            pool->parallel_for(children_count, solve_child);
+        } else {
+            for (std::size_t i = 0; i < children_count; i++) solve_child(i);
+        }
+
+        for (std::size_t i = 0; i < children_count; i++) {
+            if (!solved[i]) continue;
+            VertexSet excluded = problem.excluded;
+            excluded.insert(
+                std::upper_bound(excluded.begin(), excluded.end(), free[i]), free[i]);
+            VertexSet included = problem.included;
+            included.insert(included.end(), free.begin(), free.begin() + i);
+            std::sort(included.begin(), included.end());
+            m_solved++;
+            push(*solved[i], std::move(excluded), std::move(included));
+        }
+    }
+
+    bool stopped() const { return m_stop && m_stop(); }
+
+    DW m_root; // first sub-problem, allowed to use all the non-terminals
+
+    bool m_started;
+    long long m_solved;
+    std::size_t m_terminals_limit; // of a sub-problem, included ones counted
+    sub_problem m_current; // last reported tree
+    std::priority_queue<sub_problem, std::vector<sub_problem>,
+                        sub_problem_greater> m_queue;
+    std::function<bool()> m_stop;   // checked before each run, may be empty
+};
+
+/**
+ * @brief Creates a k_best_dreyfus_wagner object.
+ * @tparam TerminalsLimit
+ * @tparam Metric
+ * @tparam Terminals
+ * @tparam NonTerminals
+ */
+template <unsigned int TerminalsLimit = 32, typename Metric, typename Terminals, typename NonTerminals>
+k_best_dreyfus_wagner<Metric, Terminals, NonTerminals, TerminalsLimit>
+make_k_best_dreyfus_wagner(const Metric &metric, const Terminals &terminals,
+                           const NonTerminals &non_terminals) {
+    return k_best_dreyfus_wagner<Metric, Terminals, NonTerminals, TerminalsLimit>(
+        metric, terminals, non_terminals);
+}
+} // paal
+
+#endif // PAAL_K_BEST_DREYFUS_WAGNER_HPP
@@ -0,0 +1,305 @@
+//=======================================================================
+// Copyright (c)
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//=======================================================================
+/**
+ * @file k_shortest_simple_paths.hpp
+ * @brief Ranked enumeration of the simple paths between two vertices.
+ * @version 1.0
+ */
+#ifndef PAAL_K_SHORTEST_SIMPLE_PATHS_HPP
+#define PAAL_K_SHORTEST_SIMPLE_PATHS_HPP
+
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+#include <boost/range/iterator_range.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace paal {
+
+/**
+ * Yen's algorithm : the simple paths from source to target, one per call to
+ * next(), by non-decreasing cost, up to a cost budget.
+ *
+ * Each accepted path spawns one candidate per vertex of the path (the spur
+ * vertex) : the shortest deviation that keeps the path prefix, leaves the
+ * spur vertex through an edge no accepted path with the same prefix used,
+ * and avoids the prefix vertices. The cheapest candidate is the next path.
+ *
+ * The deviations are searched by A* over the distances to the target, and
+ * are cut at the budget left, so only candidates within the budget are ever
+ * stored : memory grows with the paths returned, not with the search.
+ *
+ * The vertex filter restricts the vertices a path may go through (source
+ * and target are always allowed), the edge filter the edges it may use.
+ * The graph vertices must be numbered 0..n-1, and a directed graph must
+ * hold both directions of each edge.
+ */
+template <typename Graph, typename VertexFilter, typename EdgeFilter>
+class k_shortest_simple_paths {
+  public:
+    using Vertex = typename boost::graph_traits<Graph>::vertex_descriptor;
+    using Dist = typename boost::property_traits<typename boost::property_map<
+        Graph, boost::edge_weight_t>::const_type>::value_type;
+    using Path = std::vector<Vertex>;
+
+    /**
+     * Constructor.
+     * @param budget highest cost of the returned paths
+     */
+    k_shortest_simple_paths(const Graph &graph, Vertex source, Vertex target,
+                            Dist budget, VertexFilter vertex_filter,
+                            EdgeFilter edge_filter)
+        : m_graph(graph), m_source(source), m_target(target), m_budget(budget),
+          m_vertex_filter(vertex_filter), m_edge_filter(edge_filter),
+          m_started(false), m_stopped(false), m_cost(0) {}
+
+    /**
+     * Sets a predicate polled between the deviation searches, next() returns
+     * false once it holds.
+     */
+    void set_stop_condition(std::function<bool()> stop_condition) {
+        m_stop_condition = stop_condition;
+    }
+
+    /**
+     * Computes the next path, false if there is none within the budget.
+     */
+    bool next() {
+        if (m_stopped) return false;
+        if (!m_started) {
+            m_started = true;
+            init();
+            if (m_to_target[m_source] <= m_budget) {
+                Path path;
+                Dist cost;
+                if (search(m_source, 0, path, cost)) {
+                    m_candidates.insert(candidate(cost, std::move(path)));
+                }
+            }
+        } else {
+            spur(m_accepted.back());
+        }
+        if (m_stopped || m_candidates.empty()) return false;
+
+        auto best = m_candidates.begin();
+        m_cost = best->first;
+        m_accepted.push_back(best->second);
+        m_candidates.erase(best);
+        return true;
+    }
+
+    /**
+     * Gets the cost of the current path.
+     */
+    Dist get_cost() const { return m_cost; }
+
+    /**
+     * Gets the vertices of the current path, from source to target.
+     */
+    const Path &get_path() const { return m_accepted.back(); }
+
+    /**
+     * Gets the number of paths returned so far.
+     */
+    std::size_t get_paths_count() const { return m_accepted.size(); }
+
+  private:
+    using candidate = std::pair<Dist, Path>;
+
+    /**
+     * Distances to the target over the allowed graph, the A* estimates :
+     * removing vertices and edges only makes the real distances longer.
+     */
+    void init() {
+        std::size_t n = num_vertices(m_graph);
+        const Dist infinity = std::numeric_limits<Dist>::max();
+        m_to_target.assign(n, infinity);
+        m_removed.assign(n, false);
+        m_dist.assign(n, infinity);
+        m_pred.resize(n);
+
+        using Item = std::pair<Dist, Vertex>;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+        m_to_target[m_target] = 0;
+        queue.push(Item(0, m_target));
+        while (!queue.empty()) {
+            Item item = queue.top();
+            queue.pop();
+            Vertex u = item.second;
+            if (item.first != m_to_target[u]) continue;
+            for (auto e : boost::make_iterator_range(out_edges(u, m_graph))) {
+                Vertex w = target(e, m_graph);
+                if (!allowed(w) || !m_edge_filter(w, u)) continue;
+                Dist val = item.first + get(boost::edge_weight, m_graph, e);
+                if (val < m_to_target[w]) {
+                    m_to_target[w] = val;
+                    queue.push(Item(val, w));
+                }
+            }
+        }
+    }
+
+    /**
+     * Generates the deviations of the last accepted path.
+     */
+    void spur(const Path &last) {
+        Dist root_cost = 0;
+        for (std::size_t i = 0; i + 1 < last.size(); i++) {
+            if (m_stop_condition && m_stop_condition()) {
+                m_stopped = true;
+                break;
+            }
+            Vertex spur_vertex = last[i];
+
+            // the edges out of the spur vertex already taken after this prefix
+            m_blocked.clear();
+            for (auto const &path : m_accepted) {
+                if (path.size() > i + 1 &&
+                    std::equal(last.begin(), last.begin() + i + 1, path.begin())) {
+                    m_blocked.push_back(path[i + 1]);
+                }
+            }
+
+            Path deviation;
+            Dist cost;
+            if (root_cost + m_to_target[spur_vertex] <= m_budget &&
+                search(spur_vertex, root_cost, deviation, cost)) {
+                Path path(last.begin(), last.begin() + i);
+                path.insert(path.end(), deviation.begin(), deviation.end());
+                m_candidates.insert(candidate(cost, std::move(path)));
+            }
+
+            m_removed[spur_vertex] = true;
+            root_cost += edge_weight(last[i], last[i + 1]);
+        }
+        for (auto v : last) m_removed[v] = false;
+    }
+
+    /**
+     * A* from the spur vertex to the target, avoiding the removed vertices
+     * and the blocked edges out of the spur vertex, cut at the budget.
+     * @param root_cost cost of the prefix up to the spur vertex
+     */
+    bool search(Vertex spur_vertex, Dist root_cost, Path &path, Dist &cost) {
+        const Dist infinity = std::numeric_limits<Dist>::max();
+        using Item = std::pair<Dist, Vertex>; // estimated total cost, vertex
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+
+        m_touched.clear();
+        m_dist[spur_vertex] = root_cost;
+        m_pred[spur_vertex] = spur_vertex;
+        m_touched.push_back(spur_vertex);
+        queue.push(Item(root_cost + m_to_target[spur_vertex], spur_vertex));
+
+        bool found = false;
+        while (!queue.empty()) {
+            Item item = queue.top();
+            queue.pop();
+            Vertex u = item.second;
+            if (item.first != m_dist[u] + m_to_target[u]) continue;
+            if (u == m_target) {
+                found = true;
+                break;
+            }
+            for (auto e : boost::make_iterator_range(out_edges(u, m_graph))) {
+                Vertex w = target(e, m_graph);
+                if (m_removed[w] || !allowed(w) || m_to_target[w] == infinity ||
+                    !m_edge_filter(u, w)) {
+                    continue;
+                }
+                if (u == spur_vertex &&
+                    std::find(m_blocked.begin(), m_blocked.end(), w) != m_blocked.end()) {
+                    continue;
+                }
+                Dist val = m_dist[u] + get(boost::edge_weight, m_graph, e);
+                if (val + m_to_target[w] > m_budget || val >= m_dist[w]) continue;
+                if (m_dist[w] == infinity) m_touched.push_back(w);
+                m_dist[w] = val;
+                m_pred[w] = u;
+                queue.push(Item(val + m_to_target[w], w));
+            }
+        }
+
+        if (found) {
+            cost = m_dist[m_target];
+            path.clear();
+            for (Vertex v = m_target; v != spur_vertex; v = m_pred[v]) {
+                path.push_back(v);
+            }
+            path.push_back(spur_vertex);
+            std::reverse(path.begin(), path.end());
+        }
+        for (auto v : m_touched) m_dist[v] = infinity;
+        return found;
+    }
+
+    bool allowed(Vertex v) const {
+        return v == m_source || v == m_target || m_vertex_filter(v);
+    }
+
+    /**
+     * Cheapest allowed edge between two consecutive vertices of a path.
+     */
+    Dist edge_weight(Vertex u, Vertex w) const {
+        Dist weight = std::numeric_limits<Dist>::max();
+        for (auto e : boost::make_iterator_range(out_edges(u, m_graph))) {
+            if (target(e, m_graph) == w && m_edge_filter(u, w)) {
+                weight = std::min(weight, get(boost::edge_weight, m_graph, e));
+            }
+        }
+        return weight;
+    }
+
+    const Graph &m_graph;
+    Vertex m_source;
+    Vertex m_target;
+    Dist m_budget;
+    VertexFilter m_vertex_filter;
+    EdgeFilter m_edge_filter;
+    std::function<bool()> m_stop_condition;
+
+    bool m_started;
+    bool m_stopped;
+    Dist m_cost;
+    std::vector<Path> m_accepted;       // paths returned, in order
+    std::set<candidate> m_candidates;   // deviations within the budget
+
+    std::vector<Dist> m_to_target;      // A* estimates
+    std::vector<char> m_removed;        // prefix vertices of the spur vertex
+    std::vector<Vertex> m_blocked;      // edges out of the spur vertex
+    std::vector<Dist> m_dist;           // A* state, reset after each search
+    std::vector<Vertex> m_pred;
+    std::vector<Vertex> m_touched;
+};
+
+/**
+ * @brief Creates a k_shortest_simple_paths object.
+ * @tparam Graph
+ * @tparam VertexFilter
+ * @tparam EdgeFilter
+ */
+template <typename Graph, typename VertexFilter, typename EdgeFilter>
+k_shortest_simple_paths<Graph, VertexFilter, EdgeFilter>
+make_k_shortest_simple_paths(
+    const Graph &graph,
+    typename boost::graph_traits<Graph>::vertex_descriptor source,
+    typename boost::graph_traits<Graph>::vertex_descriptor target,
+    typename k_shortest_simple_paths<Graph, VertexFilter, EdgeFilter>::Dist budget,
+    VertexFilter vertex_filter, EdgeFilter edge_filter) {
+    return k_shortest_simple_paths<Graph, VertexFilter, EdgeFilter>(
+        graph, source, target, budget, vertex_filter, edge_filter);
+}
+} // paal
+
+#endif // PAAL_K_SHORTEST_SIMPLE_PATHS_HPP
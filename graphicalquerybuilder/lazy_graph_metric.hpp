@@ -0,0 +1,224 @@
+//=======================================================================
+// Copyright (c)
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//=======================================================================
+/**
+ * @file lazy_graph_metric.hpp
+ * @brief Graph metric computing its rows on demand.
+ * @version 1.0
+ */
+#ifndef PAAL_LAZY_GRAPH_METRIC_HPP
+#define PAAL_LAZY_GRAPH_METRIC_HPP
+
+#include <boost/graph/dijkstra_shortest_paths.hpp>
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+#include <boost/property_map/property_map.hpp>
+#include <boost/range/iterator_range.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <list>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace paal {
+namespace data_structures {
+
+/**
+ * Same distances as graph_metric, without the all-pairs setup : the row of
+ * a vertex is computed by one Dijkstra the first time it is needed, and kept
+ * while it is among the rows_limit most recently used ones. The graph is
+ * undirected, so the row of either end answers a query.
+ *
+ * The queries update the cache : the metric must not be used from several
+ * threads at once.
+ */
+template <typename Graph, typename DistanceTypeParam>
+class lazy_graph_metric {
+  public:
+    using VertexType = int;
+    using DistanceType = DistanceTypeParam;
+
+    /**
+     * Constructor, the graph vertices must be numbered 0..n-1.
+     * @param rows_limit number of rows kept at most, at least 1
+     */
+    lazy_graph_metric(const Graph &graph, std::size_t rows_limit)
+        : m_graph(graph), m_rows_limit(std::max<std::size_t>(rows_limit, 1)),
+          m_rows(num_vertices(graph)), m_lru_pos(num_vertices(graph)),
+          m_cached(num_vertices(graph), false), m_computed(0) {}
+
+    /**
+     * Distance between u and v, the largest DistanceType if disconnected.
+     */
+    DistanceType operator()(VertexType u, VertexType v) const {
+        if (!m_cached[u] && m_cached[v]) return row(v)[u];
+        return row(u)[v];
+    }
+
+    /**
+     * Distance between u and v if at most bound, bound otherwise. Searches
+     * only the vertices closer to u than bound when neither row is cached,
+     * which is cheap for a bound around one edge weight.
+     */
+    DistanceType bounded_distance(VertexType u, VertexType v,
+                                  DistanceType bound) const {
+        if (m_cached[u] || m_cached[v]) return std::min((*this)(u, v), bound);
+
+        const DistanceType infinity = std::numeric_limits<DistanceType>::max();
+        m_scratch.resize(m_rows.size(), infinity);
+        m_touched.clear();
+
+        using Item = std::pair<DistanceType, VertexType>;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+        m_scratch[u] = 0;
+        m_touched.push_back(u);
+        queue.push(Item(0, u));
+        DistanceType result = bound;
+        while (!queue.empty()) {
+            Item item = queue.top();
+            queue.pop();
+            VertexType x = item.second;
+            if (item.first != m_scratch[x]) continue;
+            if (x == v) {
+                result = item.first;
+                break;
+            }
+            for (auto e : boost::make_iterator_range(out_edges(x, m_graph))) {
+                VertexType w = target(e, m_graph);
+                DistanceType val = item.first + get(boost::edge_weight, m_graph, e);
+                if (val >= bound || val >= m_scratch[w]) continue;
+                if (m_scratch[w] == infinity) m_touched.push_back(w);
+                m_scratch[w] = val;
+                queue.push(Item(val, w));
+            }
+        }
+        for (auto w : m_touched) m_scratch[w] = infinity;
+        return result;
+    }
+
+    /**
+     * To be called once the edge (u, v) was added to the graph : each kept
+     * row is lowered where the edge gives a shorter way, by a Dijkstra from
+     * its ends that only goes through the improved vertices.
+     */
+    void edge_added(VertexType u, VertexType v, DistanceType weight) {
+        for (auto s : m_lru) {
+            auto &distances = m_rows[s];
+            using Item = std::pair<DistanceType, VertexType>;
+            std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+            auto relax = [&](VertexType from, VertexType to, DistanceType w) {
+                if (distances[from] == std::numeric_limits<DistanceType>::max()) return;
+                DistanceType val = distances[from] + w;
+                if (val < distances[to]) {
+                    distances[to] = val;
+                    queue.push(Item(val, to));
+                }
+            };
+            relax(u, v, weight);
+            relax(v, u, weight);
+            while (!queue.empty()) {
+                Item item = queue.top();
+                queue.pop();
+                VertexType x = item.second;
+                if (item.first != distances[x]) continue;
+                for (auto e : boost::make_iterator_range(out_edges(x, m_graph))) {
+                    relax(x, target(e, m_graph), get(boost::edge_weight, m_graph, e));
+                }
+            }
+        }
+    }
+
+    /**
+     * To be called once the edge (u, v) was removed from the graph : the
+     * kept rows in which it was on a shortest way are dropped, to be
+     * computed again when needed. The other rows did not use it.
+     */
+    void edge_removed(VertexType u, VertexType v, DistanceType weight) {
+        const DistanceType infinity = std::numeric_limits<DistanceType>::max();
+        for (auto iter = m_lru.begin(); iter != m_lru.end();) {
+            auto &distances = m_rows[*iter];
+            bool tight = (distances[u] != infinity && distances[u] + weight == distances[v]) ||
+                         (distances[v] != infinity && distances[v] + weight == distances[u]);
+            if (!tight) {
+                ++iter;
+                continue;
+            }
+            m_cached[*iter] = false;
+            std::vector<DistanceType>().swap(distances);
+            iter = m_lru.erase(iter);
+        }
+    }
+
+    /**
+     * Gets the number of rows currently kept.
+     */
+    std::size_t get_rows_count() const { return m_lru.size(); }
+
+    /**
+     * Gets the number of Dijkstra runs so far, evicted rows computed again
+     * included.
+     */
+    std::size_t get_computed_rows_count() const { return m_computed; }
+
+    /**
+     * Gets the memory used by the kept rows, in bytes.
+     */
+    std::size_t get_memory_usage() const {
+        return m_lru.size() * m_rows.size() * sizeof(DistanceType);
+    }
+
+  private:
+    /**
+     * Row of u, computed if not kept, and marked as the most recently used.
+     */
+    const std::vector<DistanceType> &row(VertexType u) const {
+        if (m_cached[u]) {
+            m_lru.splice(m_lru.begin(), m_lru, m_lru_pos[u]);
+            return m_rows[u];
+        }
+
+        std::vector<DistanceType> distances;
+        if (m_lru.size() >= m_rows_limit) {
+            VertexType evicted = m_lru.back();
+            m_lru.pop_back();
+            m_cached[evicted] = false;
+            distances.swap(m_rows[evicted]); // reuses its buffer
+        }
+        distances.assign(m_rows.size(), std::numeric_limits<DistanceType>::max());
+        boost::dijkstra_shortest_paths(
+            m_graph, u,
+            boost::distance_map(boost::make_iterator_property_map(
+                distances.begin(), get(boost::vertex_index, m_graph))));
+        m_computed++;
+
+        m_rows[u].swap(distances);
+        m_lru.push_front(u);
+        m_lru_pos[u] = m_lru.begin();
+        m_cached[u] = true;
+        return m_rows[u];
+    }
+
+    const Graph &m_graph;
+    std::size_t m_rows_limit;
+
+    mutable std::vector<std::vector<DistanceType>> m_rows; // empty if not kept
+    mutable std::list<VertexType> m_lru;   // kept rows, most recent first
+    mutable std::vector<typename std::list<VertexType>::iterator> m_lru_pos;
+    mutable std::vector<char> m_cached;    // is the row kept
+    mutable std::size_t m_computed;
+
+    mutable std::vector<DistanceType> m_scratch; // bounded_distance state
+    mutable std::vector<VertexType> m_touched;
+};
+
+} // data_structures
+} // paal
+
+#endif // PAAL_LAZY_GRAPH_METRIC_HPP
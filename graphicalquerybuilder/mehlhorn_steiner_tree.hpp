@@ -0,0 +1,263 @@
+//=======================================================================
+// Copyright (c)
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//=======================================================================
+/**
+ * @file mehlhorn_steiner_tree.hpp
+ * @brief Approximates the Steiner Tree in O(m log n).
+ * @version 1.0
+ */
+#ifndef PAAL_MEHLHORN_STEINER_TREE_HPP
+#define PAAL_MEHLHORN_STEINER_TREE_HPP
+
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+#include <boost/range/iterator_range.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace paal {
+
+/**
+ * Mehlhorn's version of the Kou-Markowsky-Berman algorithm.
+ *
+ * One Dijkstra from all the terminals at once splits the graph in Voronoi
+ * regions, each vertex belonging to its closest terminal. Each edge between
+ * two regions gives a path between their terminals ; the minimum spanning
+ * tree of those paths (Kruskal) is a minimum spanning tree of the terminals
+ * distance network. Its paths are expanded into graph edges, whose union is
+ * cleaned by one more spanning tree and the removal of the non-terminal
+ * leaves.
+ *
+ * O(m log n), and the tree costs at most 2 - 2/k times the optimal one.
+ */
+template <typename Graph, typename Terminals>
+class mehlhorn_steiner_tree {
+  public:
+    using Vertex = typename boost::graph_traits<Graph>::vertex_descriptor;
+    using Dist = typename boost::property_traits<typename boost::property_map<
+        Graph, boost::edge_weight_t>::const_type>::value_type;
+    using Edge = std::pair<Vertex, Vertex>;
+    using steiner_elements = std::unordered_set<Vertex>;
+
+    /**
+     * Constructor, the graph vertices must be numbered 0..n-1.
+     */
+    mehlhorn_steiner_tree(const Graph &graph, const Terminals &term)
+        : m_graph(graph), m_terminals(term), m_cost(0) {}
+
+    /**
+     * Builds the tree.
+     */
+    void solve() {
+        std::size_t n = num_vertices(m_graph);
+        m_cost = 0;
+        m_edges.clear();
+        m_steiner_elements.clear();
+        m_terminal.assign(n, false);
+        for (auto t : m_terminals) m_terminal[t] = true;
+
+        voronoi_regions();
+
+        // Kruskal on the edges between regions, by length of their path
+        std::vector<weighted_edge> bridges;
+        auto weight = get(boost::edge_weight, m_graph);
+        for (auto e : boost::make_iterator_range(edges(m_graph))) {
+            Vertex u = source(e, m_graph), v = target(e, m_graph);
+            if (m_base[u] == n || m_base[v] == n || m_base[u] == m_base[v]) continue;
+            bridges.push_back(weighted_edge(m_dist[u] + weight[e] + m_dist[v],
+                                            u, v, weight[e]));
+        }
+        std::sort(bridges.begin(), bridges.end());
+
+        std::vector<weighted_edge> paths_edges;
+        init_sets(n);
+        for (auto const &bridge : bridges) {
+            Vertex u = std::get<1>(bridge), v = std::get<2>(bridge);
+            if (!join(m_base[u], m_base[v])) continue;
+            paths_edges.push_back(weighted_edge(std::get<3>(bridge), u, v,
+                                                std::get<3>(bridge)));
+            for (Vertex w : {u, v}) {
+                for (; w != m_base[w]; w = m_pred[w]) {
+                    Dist length = m_dist[w] - m_dist[m_pred[w]];
+                    paths_edges.push_back(weighted_edge(length, m_pred[w], w, length));
+                }
+            }
+        }
+
+        // The paths may share edges and form cycles
+        std::sort(paths_edges.begin(), paths_edges.end());
+        std::vector<std::vector<std::pair<Vertex, Dist>>> tree(n);
+        init_sets(n);
+        for (auto const &e : paths_edges) {
+            Vertex u = std::get<1>(e), v = std::get<2>(e);
+            if (!join(u, v)) continue;
+            tree[u].push_back(std::make_pair(v, std::get<3>(e)));
+            tree[v].push_back(std::make_pair(u, std::get<3>(e)));
+        }
+        prune_and_retrieve(tree);
+    }
+
+    /**
+     * Gets the tree cost.
+     */
+    Dist get_cost() const { return m_cost; }
+
+    /**
+     * Gets the tree edges, edges of the graph.
+     */
+    const std::vector<Edge> &get_edges() const { return m_edges; }
+
+    /**
+     * Gets the non-terminals of the tree.
+     */
+    const steiner_elements &get_steiner_elements() const {
+        return m_steiner_elements;
+    }
+
+    /**
+     * Gets the bound on the ratio between the tree cost and the optimal one.
+     */
+    double get_approximation_ratio() const {
+        std::size_t k = m_terminals.size();
+        return k < 2 ? 1. : 2. - 2. / k;
+    }
+
+  private:
+    // length, source, target, weight of the edge
+    using weighted_edge = std::tuple<Dist, Vertex, Vertex, Dist>;
+
+    /**
+     * Multi-source Dijkstra from the terminals : m_base is the closest
+     * terminal, n if unreachable.
+     */
+    void voronoi_regions() {
+        std::size_t n = num_vertices(m_graph);
+        auto weight = get(boost::edge_weight, m_graph);
+        m_dist.assign(n, std::numeric_limits<Dist>::max());
+        m_base.assign(n, n);
+        m_pred.resize(n);
+
+        using Item = std::pair<Dist, Vertex>;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+        for (auto t : m_terminals) {
+            m_dist[t] = 0;
+            m_base[t] = t;
+            m_pred[t] = t;
+            queue.push(Item(0, t));
+        }
+        while (!queue.empty()) {
+            Item item = queue.top();
+            queue.pop();
+            Vertex u = item.second;
+            if (item.first != m_dist[u]) continue;
+            for (auto e : boost::make_iterator_range(out_edges(u, m_graph))) {
+                Vertex w = target(e, m_graph);
+                Dist val = m_dist[u] + weight[e];
+                if (val < m_dist[w]) {
+                    m_dist[w] = val;
+                    m_base[w] = m_base[u];
+                    m_pred[w] = u;
+                    queue.push(Item(val, w));
+                }
+            }
+        }
+    }
+
+    /**
+     * Removes the non-terminal leaves until none is left, then stores the
+     * remaining edges.
+     */
+    void prune_and_retrieve(const std::vector<std::vector<std::pair<Vertex, Dist>>> &tree) {
+        std::size_t n = tree.size();
+        std::vector<std::size_t> degree(n);
+        std::vector<char> removed(n, false);
+        std::vector<Vertex> leaves;
+        for (Vertex v = 0; v < n; v++) {
+            degree[v] = tree[v].size();
+            if (degree[v] == 1 && !m_terminal[v]) leaves.push_back(v);
+        }
+        while (!leaves.empty()) {
+            Vertex v = leaves.back();
+            leaves.pop_back();
+            removed[v] = true;
+            for (auto const &adj : tree[v]) {
+                Vertex w = adj.first;
+                if (removed[w]) continue;
+                if (--degree[w] == 1 && !m_terminal[w]) leaves.push_back(w);
+            }
+        }
+
+        for (Vertex v = 0; v < n; v++) {
+            if (removed[v] || degree[v] == 0) continue;
+            if (!m_terminal[v]) m_steiner_elements.insert(v);
+            for (auto const &adj : tree[v]) {
+                if (adj.first < v || removed[adj.first]) continue;
+                m_edges.push_back(Edge(v, adj.first));
+                m_cost += adj.second;
+            }
+        }
+    }
+
+    void init_sets(std::size_t n) {
+        m_set.resize(n);
+        std::iota(m_set.begin(), m_set.end(), Vertex(0));
+    }
+
+    Vertex find_set(Vertex v) {
+        while (m_set[v] != v) {
+            m_set[v] = m_set[m_set[v]];
+            v = m_set[v];
+        }
+        return v;
+    }
+
+    /**
+     * Merges the sets of u and v, false if they were already the same.
+     */
+    bool join(Vertex u, Vertex v) {
+        u = find_set(u);
+        v = find_set(v);
+        if (u == v) return false;
+        m_set[u] = v;
+        return true;
+    }
+
+    const Graph &m_graph;
+    const Terminals &m_terminals;
+
+    Dist m_cost;
+    std::vector<Edge> m_edges;
+    steiner_elements m_steiner_elements;
+
+    std::vector<char> m_terminal;  // terminal membership of each vertex
+    std::vector<Dist> m_dist;      // distance to the closest terminal
+    std::vector<Vertex> m_base;    // closest terminal
+    std::vector<Vertex> m_pred;    // previous vertex on the way from it
+    std::vector<Vertex> m_set;     // union-find forest
+};
+
+/**
+ * @brief Creates a mehlhorn_steiner_tree object.
+ * @tparam Graph
+ * @tparam Terminals
+ */
+template <typename Graph, typename Terminals>
+mehlhorn_steiner_tree<Graph, Terminals>
+make_mehlhorn_steiner_tree(const Graph &graph, const Terminals &terminals) {
+    return mehlhorn_steiner_tree<Graph, Terminals>(graph, terminals);
+}
+} // paal
+
+#endif // PAAL_MEHLHORN_STEINER_TREE_HPP
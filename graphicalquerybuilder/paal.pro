@@ -68,12 +68,14 @@ HEADERS += docs/namespaces.hpp \
            include/paal/data_structures/fraction.hpp \
            include/paal/data_structures/mapped_file.hpp \
            include/paal/data_structures/object_with_copy.hpp \
+           include/paal/data_structures/set_trie.hpp \
            include/paal/data_structures/splay_tree.hpp \
            include/paal/data_structures/stack.hpp \
            include/paal/data_structures/subset_iterator.hpp \
            include/paal/data_structures/thread_pool.hpp \
            include/paal/data_structures/ublas_traits.hpp \
            include/paal/data_structures/vertex_to_edge_iterator.hpp \
+           include/paal/data_structures/work_stealing_pool.hpp \
            include/paal/dynamic/knapsack_0_1.hpp \
            include/paal/dynamic/knapsack_0_1_fptas.hpp \
            include/paal/dynamic/knapsack_unbounded.hpp \
@@ -105,6 +107,9 @@ HEADERS += docs/namespaces.hpp \
            include/paal/regression/lsh_nearest_neighbors_regression.hpp \
            include/paal/sketch/frequent_directions.hpp \
            include/paal/steiner_tree/dreyfus_wagner.hpp \
+           include/paal/steiner_tree/k_best_dreyfus_wagner.hpp \
+           include/paal/steiner_tree/shortest_path_steiner_tree.hpp \
+           include/paal/steiner_tree/mehlhorn_steiner_tree.hpp \
            include/paal/steiner_tree/zelikovsky_11_per_6.hpp \
            include/paal/utils/accumulate_functors.hpp \
            include/paal/utils/assign_updates.hpp \
@@ -118,6 +123,7 @@ HEADERS += docs/namespaces.hpp \
            include/paal/utils/infinity.hpp \
            include/paal/utils/irange.hpp \
            include/paal/utils/iterator_utils.hpp \
+           include/paal/utils/k_shortest_simple_paths.hpp \
            include/paal/utils/knapsack_utils.hpp \
            include/paal/utils/less_pointees.hpp \
            include/paal/utils/make.hpp \
@@ -155,6 +161,7 @@ HEADERS += docs/namespaces.hpp \
            include/paal/data_structures/metric/basic_metrics.hpp \
            include/paal/data_structures/metric/euclidean_metric.hpp \
            include/paal/data_structures/metric/graph_metrics.hpp \
+           include/paal/data_structures/metric/lazy_graph_metric.hpp \
            include/paal/data_structures/metric/metric_on_idx.hpp \
            include/paal/data_structures/metric/metric_to_bgl.hpp \
            include/paal/data_structures/metric/metric_traits.hpp \
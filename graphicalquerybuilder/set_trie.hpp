@@ -0,0 +1,211 @@
+//=======================================================================
+// Copyright (c)
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//=======================================================================
+/**
+ * @file set_trie.hpp
+ * @brief Sets index answering subset and superset queries.
+ * @version 1.0
+ */
+#ifndef PAAL_SET_TRIE_HPP
+#define PAAL_SET_TRIE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace paal {
+namespace data_structures {
+
+/**
+ * Set-trie : a prefix tree over the sets given as sorted sequences of
+ * distinct elements, each stored set ending at a node with its value.
+ *
+ * A stored subset of a set s is found by only following the children
+ * labelled with the elements of s, in order ; the stored supersets of s
+ * are found by following any child labelled with an element lower than the
+ * next element of s to cover, and the child labelled with it. So both
+ * queries only visit the paths that can match instead of every set.
+ *
+ * Each node counts the sets stored below it : the queries skip the
+ * subtrees emptied by removals, whose nodes are kept for later insertions.
+ */
+template <typename Element, typename Value, typename Compare = std::less<Element>>
+class set_trie {
+  public:
+    set_trie() : m_nodes(1) {}
+
+    /**
+     * Stores a set, false if an equal set is already stored.
+     * @param set sorted range of distinct elements
+     */
+    template <typename Set> bool insert(const Set &set, Value value) {
+        std::size_t node = 0;
+        for (auto const &element : set) {
+            auto &children = m_nodes[node].children;
+            auto iter = lower_bound(children, element);
+            if (iter == children.end() || m_compare(element, iter->first)) {
+                std::size_t child = m_nodes.size();
+                children.insert(iter, std::make_pair(element, child));
+                m_nodes.emplace_back(); // children is no longer valid
+                node = child;
+            } else {
+                node = iter->second;
+            }
+        }
+        if (m_nodes[node].stored) return false;
+
+        m_nodes[node].stored = true;
+        m_nodes[node].value = std::move(value);
+        node = 0;
+        m_nodes[0].count++;
+        for (auto const &element : set) {
+            node = lower_bound(m_nodes[node].children, element)->second;
+            m_nodes[node].count++;
+        }
+        return true;
+    }
+
+    /**
+     * Removes a stored set, false if it is not stored.
+     * @param set sorted range of distinct elements
+     */
+    template <typename Set> bool erase(const Set &set) {
+        std::vector<std::size_t> nodes(1, 0);
+        for (auto const &element : set) {
+            auto const &children = m_nodes[nodes.back()].children;
+            auto iter = lower_bound(children, element);
+            if (iter == children.end() || m_compare(element, iter->first)) {
+                return false;
+            }
+            nodes.push_back(iter->second);
+        }
+        if (!m_nodes[nodes.back()].stored) return false;
+
+        m_nodes[nodes.back()].stored = false;
+        for (auto node : nodes) m_nodes[node].count--;
+        return true;
+    }
+
+    /**
+     * Tells whether a subset of the given set, itself included, is stored.
+     * @param set sorted range of distinct elements
+     */
+    template <typename Set> bool has_subset(const Set &set) const {
+        return has_subset(0, std::begin(set), std::end(set));
+    }
+
+    /**
+     * Removes the stored supersets of the given set, itself included,
+     * passing each value to removed.
+     * @param set sorted range of distinct elements
+     */
+    template <typename Set, typename Functor>
+    void remove_supersets(const Set &set, Functor removed) {
+        remove_supersets(0, std::begin(set), std::end(set), removed);
+    }
+
+    /**
+     * Gets the number of stored sets.
+     */
+    std::size_t size() const { return m_nodes[0].count; }
+
+    /**
+     * Gets the number of nodes, the removed sets' ones included.
+     */
+    std::size_t get_nodes_count() const { return m_nodes.size(); }
+
+    /**
+     * Gets the approximate bytes of the nodes, the removed sets' ones included.
+     */
+    std::size_t get_memory_usage() const {
+        // each node but the root is one child entry of its parent
+        return m_nodes.capacity() *
+               (sizeof(node) + sizeof(typename Children::value_type));
+    }
+
+  private:
+    using Children = std::vector<std::pair<Element, std::size_t>>; // sorted
+
+    struct node {
+        node() : stored(false), count(0) {}
+
+        Children children;
+        bool stored;       // does a set end here
+        Value value;       // its value
+        std::size_t count; // sets stored in the subtree
+    };
+
+    template <typename Iterator>
+    bool has_subset(std::size_t node, Iterator begin, Iterator end) const {
+        if (m_nodes[node].stored) return true;
+        auto const &children = m_nodes[node].children;
+        for (; begin != end && !children.empty(); ++begin) {
+            auto iter = lower_bound(children, *begin);
+            if (iter == children.end()) return false; // no child left to match
+            if (m_compare(*begin, iter->first) || m_nodes[iter->second].count == 0) {
+                continue;
+            }
+            Iterator next = begin;
+            if (has_subset(iter->second, ++next, end)) return true;
+        }
+        return false;
+    }
+
+    /**
+     * Removes the stored supersets below the node of [begin, end), and
+     * gives the number of removed sets.
+     */
+    template <typename Iterator, typename Functor>
+    std::size_t remove_supersets(std::size_t node, Iterator begin, Iterator end,
+                                 Functor &removed) {
+        std::size_t count = 0;
+        if (begin == end && m_nodes[node].stored) {
+            m_nodes[node].stored = false;
+            removed(m_nodes[node].value);
+            count++;
+        }
+        // indices, since the children of the node are not modified
+        for (std::size_t i = 0; i < m_nodes[node].children.size(); i++) {
+            auto const &child = m_nodes[node].children[i];
+            if (begin != end && m_compare(*begin, child.first)) break;
+            if (m_nodes[child.second].count == 0) continue;
+            Iterator next = begin;
+            if (begin != end && !m_compare(child.first, *begin)) ++next;
+            count += remove_supersets(child.second, next, end, removed);
+        }
+        m_nodes[node].count -= count;
+        return count;
+    }
+
+    typename Children::const_iterator lower_bound(const Children &children,
+                                                  const Element &element) const {
+        return std::lower_bound(children.begin(), children.end(), element,
+                                [this](const std::pair<Element, std::size_t> &child,
+                                       const Element &e) {
+            return m_compare(child.first, e);
+        });
+    }
+
+    typename Children::iterator lower_bound(Children &children,
+                                            const Element &element) {
+        return std::lower_bound(children.begin(), children.end(), element,
+                                [this](const std::pair<Element, std::size_t> &child,
+                                       const Element &e) {
+            return m_compare(child.first, e);
+        });
+    }
+
+    std::vector<node> m_nodes; // m_nodes[0] is the root, the empty set
+    Compare m_compare;
+};
+
+} // data_structures
+} // paal
+
+#endif // PAAL_SET_TRIE_HPP
@@ -8,6 +8,13 @@ do
 		cd paal
 		cp ../paal.pro .
 		cp ../dreyfus_wagner.hpp include/paal/steiner_tree/.
+		cp ../k_best_dreyfus_wagner.hpp include/paal/steiner_tree/.
+		cp ../shortest_path_steiner_tree.hpp include/paal/steiner_tree/.
+		cp ../mehlhorn_steiner_tree.hpp include/paal/steiner_tree/.
+		cp ../work_stealing_pool.hpp include/paal/data_structures/.
+		cp ../lazy_graph_metric.hpp include/paal/data_structures/metric/.
+		cp ../set_trie.hpp include/paal/data_structures/.
+		cp ../k_shortest_simple_paths.hpp include/paal/utils/.
 		cd ..
 	fi
 
@@ -0,0 +1,168 @@
+//=======================================================================
+// Copyright (c)
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//=======================================================================
+/**
+ * @file shortest_path_steiner_tree.hpp
+ * @brief Approximates the Steiner Tree in polynomial time.
+ * @version 1.0
+ */
+#ifndef PAAL_SHORTEST_PATH_STEINER_TREE_HPP
+#define PAAL_SHORTEST_PATH_STEINER_TREE_HPP
+
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+#include <boost/range/iterator_range.hpp>
+
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace paal {
+
+/**
+ * Shortest path heuristic (Takahashi-Matsuyama) : the tree starts from the
+ * first terminal, then the closest terminal not yet in the tree is joined
+ * to it through a shortest path, until all terminals are in the tree.
+ * One multi-source Dijkstra per terminal, so O(k * m log n), and the tree
+ * costs at most 2 - 2/k times the optimal one.
+ *
+ * Unlike dreyfus_wagner, the edges are the graph's own edges, and there is
+ * no limit on the number of terminals.
+ */
+template <typename Graph, typename Terminals>
+class shortest_path_steiner_tree {
+  public:
+    using Vertex = typename boost::graph_traits<Graph>::vertex_descriptor;
+    using Dist = typename boost::property_traits<typename boost::property_map<
+        Graph, boost::edge_weight_t>::const_type>::value_type;
+    using Edge = std::pair<Vertex, Vertex>;
+    using steiner_elements = std::unordered_set<Vertex>;
+
+    /**
+     * Constructor, the graph vertices must be numbered 0..n-1.
+     */
+    shortest_path_steiner_tree(const Graph &graph, const Terminals &term)
+        : m_graph(graph), m_terminals(term), m_cost(0) {}
+
+    /**
+     * Builds the tree.
+     */
+    void solve() {
+        std::size_t n = num_vertices(m_graph);
+        const Dist infinity = std::numeric_limits<Dist>::max();
+        auto weight = get(boost::edge_weight, m_graph);
+
+        std::vector<char> in_tree(n, false), terminal(n, false);
+        for (auto t : m_terminals) terminal[t] = true;
+        std::size_t missing = 0;
+        for (std::size_t v = 0; v < n; v++) missing += terminal[v];
+
+        m_cost = 0;
+        m_edges.clear();
+        m_steiner_elements.clear();
+        if (missing == 0) return;
+
+        in_tree[*m_terminals.begin()] = true;
+        missing--;
+
+        std::vector<Dist> dist(n);
+        std::vector<Vertex> pred(n);
+        using Item = std::pair<Dist, Vertex>;
+        while (missing > 0) {
+            // Dijkstra from the whole tree, up to the closest terminal
+            std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+            for (std::size_t v = 0; v < n; v++) {
+                dist[v] = in_tree[v] ? 0 : infinity;
+                pred[v] = v;
+                if (in_tree[v]) queue.push(Item(0, v));
+            }
+            Vertex reached = n;
+            while (!queue.empty()) {
+                Item item = queue.top();
+                queue.pop();
+                Vertex u = item.second;
+                if (item.first != dist[u]) continue;
+                if (terminal[u] && !in_tree[u]) {
+                    reached = u;
+                    break;
+                }
+                for (auto e : boost::make_iterator_range(out_edges(u, m_graph))) {
+                    Vertex w = target(e, m_graph);
+                    Dist val = dist[u] + weight[e];
+                    if (val < dist[w]) {
+                        dist[w] = val;
+                        pred[w] = u;
+                        queue.push(Item(val, w));
+                    }
+                }
+            }
+            // the remaining terminals are not connected to the tree
+            if (reached == n) break;
+
+            m_cost += dist[reached];
+            for (Vertex v = reached; !in_tree[v]; v = pred[v]) {
+                in_tree[v] = true;
+                m_edges.push_back(Edge(pred[v], v));
+                if (terminal[v]) {
+                    missing--;
+                } else {
+                    m_steiner_elements.insert(v);
+                }
+            }
+        }
+    }
+
+    /**
+     * Gets the tree cost.
+     */
+    Dist get_cost() const { return m_cost; }
+
+    /**
+     * Gets the tree edges, edges of the graph.
+     */
+    const std::vector<Edge> &get_edges() const { return m_edges; }
+
+    /**
+     * Gets the non-terminals of the tree.
+     */
+    const steiner_elements &get_steiner_elements() const {
+        return m_steiner_elements;
+    }
+
+    /**
+     * Gets the bound on the ratio between the tree cost and the optimal one.
+     */
+    double get_approximation_ratio() const {
+        std::size_t k = m_terminals.size();
+        return k < 2 ? 1. : 2. - 2. / k;
+    }
+
+  private:
+    const Graph &m_graph;
+    const Terminals &m_terminals;
+
+    Dist m_cost;
+    std::vector<Edge> m_edges;
+    steiner_elements m_steiner_elements;
+};
+
+/**
+ * @brief Creates a shortest_path_steiner_tree object.
+ * @tparam Graph
+ * @tparam Terminals
+ */
+template <typename Graph, typename Terminals>
+shortest_path_steiner_tree<Graph, Terminals>
+make_shortest_path_steiner_tree(const Graph &graph, const Terminals &terminals) {
+    return shortest_path_steiner_tree<Graph, Terminals>(graph, terminals);
+}
+} // paal
+
+#endif // PAAL_SHORTEST_PATH_STEINER_TREE_HPP
@@ -784,12 +784,13 @@ void GraphicalQueryBuilderCoreWidget::updateRelLabel(void)
 		rel_cnt=gqb_j->manual_path_tw->rowCount();
 	}
 
-	else if(path_mode_set.first==GraphicalQueryBuilderPathWidget::Automatic && gqb_j->auto_path_tw->rowCount()>0)
+#ifdef GRAPHICAL_QUERY_BUILDER_JOIN_SOLVER
+	else if(path_mode_set.first==GraphicalQueryBuilderPathWidget::Automatic && gqb_j->auto_paths_model->getPathsCount()>0)
 	{
 		mode=tr("Auto%1: ").arg(path_mode_set.second+1);
-		rel_cnt=dynamic_cast<QTreeWidget *>(
-			gqb_j->auto_path_tw->cellWidget(path_mode_set.second,0))->topLevelItem(0)->childCount();
+		rel_cnt=gqb_j->auto_paths_model->getRelationshipsCount(path_mode_set.second);
 	}
+#endif
 
 	if(rel_cnt==0)
 		rel_cnt_lbl->setVisible(false);
@@ -1042,6 +1043,7 @@ std::tuple<QHash<BaseTable *, int>, std::vector<QPair<int, int> >, QHash<QPair<i
 	QHash<BaseTable*, int> result_first;
 	std::vector<QPair<int, int>> result_second;
 	QHash<QPair<int, int>, QPair<BaseRelationship*, int>> result_third;
+	QSet<QPair<int, int>> edges_in; //the edges of result_second, one lookup each
 	int i=0;
 	for(const auto &vertex:required_vertices)
 		if(!disconnected_vertices.contains(vertex)) result_first.insert(vertex, i++);
@@ -1054,18 +1056,9 @@ std::tuple<QHash<BaseTable *, int>, std::vector<QPair<int, int> >, QHash<QPair<i
 		auto edge_reversed = qMakePair<int,int>(
 					result_first.value(connected_rel.second->getTable(BaseRelationship::DstTable)),
 					result_first.value(connected_rel.second->getTable(BaseRelationship::SrcTable)));
-		bool already_in=false;
-		for(const auto &existing_edge:result_second)
-		{
-			if(edge==existing_edge)
-			{
-				already_in=true;
-				break;
-			}
-		}
-
-		if(!already_in)
+		if(!edges_in.contains(edge))
 		{
+			edges_in.insert(edge);
 			result_second.push_back(edge);
 			result_third.insert(edge, qMakePair(connected_rel.second, 1));
 			result_third.insert(edge_reversed, qMakePair(connected_rel.second, 1));
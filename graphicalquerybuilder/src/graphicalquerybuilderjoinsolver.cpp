@@ -18,8 +18,11 @@
 
 #include "graphicalquerybuilderpathwidget.h"
 #include "graphicalquerybuildercorewidget.h"
+#include <QtMath>
 
 #include <boost/range/algorithm/copy.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <climits>
 #include <iostream>
 #include <QtAlgorithms>
 
@@ -28,7 +31,7 @@ typedef boost::adjacency_list<
 	boost::vecS, boost::vecS, boost::undirectedS,
 	boost::property<boost::vertex_color_t, int>, EdgeProp>  Graph ;
 using Edge = QPair<int, int>;
-using GraphMT = paal::data_structures::graph_metric<Graph, int>;
+using GraphMT = paal::data_structures::lazy_graph_metric<Graph, int>;
 using Terminals = std::vector<int>;
 using edge_parallel_category = boost::allow_parallel_edge_tag;
 using CostMap=paal::data_structures::graph_metric<Graph,
@@ -36,14 +39,36 @@ using CostMap=paal::data_structures::graph_metric<Graph,
 
 using Path = QVector<Edge>;
 
+//! \brief Copies the tree of an approximated engine in the addSteinerTree() format.
+template <typename Tree>
+static void readApproximatedTree(const Tree &tree,
+								 std::vector<std::pair<int, int>> &tree_edges,
+								 QVector<int> &tree_steiners)
+{
+	for(auto edge:tree.get_edges())
+		tree_edges.push_back(std::pair<int, int>(edge.first, edge.second));
+
+	for(auto se:tree.get_steiner_elements())
+		tree_steiners.push_back(se);
+	std::sort(tree_steiners.begin(), tree_steiners.end());
+}
+
 GraphicalQueryBuilderJoinSolver::GraphicalQueryBuilderJoinSolver(
-			GraphicalQueryBuilderPathWidget *widget, QThread *thread, bool real_time_rendering, int delay) : QObject()
+			GraphicalQueryBuilderPathWidget *widget, GraphicalQueryBuilderSolverCache *cache,
+			GraphicalQueryBuilderProgress *progress,
+			GraphicalQueryBuilderHighlights *highlights,
+			bool real_time_rendering) : QObject()
 {
 	gqb_p=widget;
+	this->cache=cache;
+	this->progress=progress;
+	this->highlights=highlights;
 	stop_solver_requested=false;
-	this_thread=thread;
+	deadline_reached=false;
+	paths_bytes=sub_paths_bytes=trees_bytes=0;
+	memory_ceiling=0;
+	memory_pruned=false;
 	this->real_time_rendering=real_time_rendering;
-	this->delay=delay;
 }
 
 
@@ -70,40 +95,129 @@ void GraphicalQueryBuilderJoinSolver::findPaths()
 	// I.1	Initialize the containers
 
 	/*
-	 * The final result is a uniquely associative container, as follows :
-	 * a QMultimap can have various keys identical,
-	 * it is useful since we can have many paths that have a same total weight.
-	 * So each entry is a unique path, and the key is the total path weight.
-	 * The multimap value is a pair :
-	 *   - a pair of vectors of basetables part of the path
+	 * The final result is a set of unique paths, each one stored with :
+	 *   - its total path weight,
+	 *   - the basetables part of the path
 	 *		(1 steiner points, and 2 non-terminal non-steiner points),
-	 *   - a vector of paths (1 relation object 2 relation weight).
+	 *   - its relationships, as a bitset over the relationship ids.
+	 * The paths are ordered by weight once displayed.
 	 */
-	QMultiMap<int,
-			QPair<
-					QPair<QVector<BaseTable*>, QVector<BaseTable*>>,
-					QVector<QPair<BaseRelationship*, int>
-			>>> super_res;
+	GraphicalQueryBuilderPaths super_res;
+
+	//Relationship sets of super_res, a path being only kept if no other one
+	//uses a subset of its relationships.
+	PathsIndex super_res_index;
+
+	//I.2.	Tables, relationships and their costs, the graph and its metric :
+	//		kept from the previous run on the model if nothing changed since,
+	//		else compared with it.
+	QString weights_key=QString("%1 %2")
+			.arg(gqb_p->default_cost_sb->value())
+			.arg(gqb_p->cross_sch_cost_sb->value());
+	for(int i=0; i<gqb_p->custom_costs_tw->rowCount();i++)
+		weights_key+=QString("\n%1 %2 %3 %4")
+				.arg(dynamic_cast<QComboBox *>(gqb_p->custom_costs_tw->cellWidget(i,0))->currentText())
+				.arg(dynamic_cast<QComboBox *>(gqb_p->custom_costs_tw->cellWidget(i,1))->currentText())
+				.arg(gqb_p->custom_costs_tw->item(i,2)->text())
+				.arg(gqb_p->custom_costs_tw->item(i,3)->text());
+
+	BaseTable *root_vertex=reinterpret_cast<BaseTable *>(
+				gqb_p->gqb_c->tab_wgt->item(GraphicalQueryBuilderCoreWidget::tW_Table,0)->data(Qt::UserRole).value<void *>());
+
+	//Hidden relationships do not signal anything : always compared.
+	if(cache->graph && !cache->model_changed && !gqb_p->vis_only_cb->isChecked() &&
+		cache->weights_key==weights_key && cache->tables.contains(root_vertex))
+	{
+		gqb_p->gqb_c->disconnected_vertices=cache->disconnected_vertices;
+	}
+	else
+	{
+		//Cleared first : an edit made during the setup marks the cache again.
+		cache->model_changed=false;
+		cache->k_best_dw.reset();
+		cache->reduced_metric.reset();
+
+		//I.2.a	Detect connected components
+		auto return_tuple=gqb_p->gqb_c->getConnectedComponents();
+		QHash<BaseTable*, int> tables=std::move(get<0>(return_tuple));
+		vector<Edge> edges=std::move(get<1>(return_tuple));
+		QHash<Edge, QPair<BaseRelationship*, int>> edges_hash=std::move(get<2>(return_tuple));
+
+		QHash<int, BaseTable*> tables_r;
+		for (auto it=tables.begin();it!=tables.end();it++)
+			tables_r.insert(it.value(), it.key());
+
+		//I.2.b	Set relation costs
+		vector<int> weights=computeWeights(edges, tables_r, edges_hash);
+
+		//I.2.c	Setup the boost graph and its paal metric :
+		//		the distances from a table are only computed once asked for.
+		//		On the same tables, the relationship changes only drop the metric rows
+		//		they affect.
+		if(!cache->graph || !updateCache(tables, edges, edges_hash))
+		{
+			cache->metric.reset();
+			cache->graph.reset(new Graph(edges.begin(), edges.end(), weights.begin(), tables.size()));
+			cache->metric.reset(new GraphMT(*cache->graph, metric_rows_limit));
+		}
 
-	//Two lookup containers that are the reverse of each other,
-	//dual-mapping table  object + table number in boost format
-	QHash<BaseTable*, int> tables;
-	QHash<int, BaseTable*> tables_r;
+		//I.2.d	Compressed sparse row copy of the graph for the path expansion :
+		//		each table's relationships are contiguous, next to their weight.
+		//		Only the relationships that are the shortest way between their two tables
+		//		can be on a path, the others are left out once here.
+		std::vector<std::pair<int, int>> csr_edges;
+		std::vector<CsrEdgeProp> csr_props;
+		for(auto it=edges_hash.begin();it!=edges_hash.end();it++)
+		{
+			if(cache->metric->bounded_distance(it.key().first, it.key().second, it.value().second)!=it.value().second)
+				continue;
+			csr_edges.push_back(std::make_pair(it.key().first, it.key().second));
+			csr_props.push_back(CsrEdgeProp(it.value().second, it.value().first));
+		}
+		cache->csr.reset(new CsrGraph(boost::edges_are_unsorted_multi_pass, csr_edges.begin(), csr_edges.end(),
+									  csr_props.begin(), tables.size()));
 
-	vector<Edge> edges;
+		//I.2.e	Relationship ids, the paths being sets of them
+		cache->relationships.clear();
+		cache->relationship_ids.clear();
+		QHash<BaseRelationship*, int> ids;
+		for(auto it=edges_hash.begin();it!=edges_hash.end();it++)
+		{
+			if(!ids.contains(it.value().first))
+			{
+				ids.insert(it.value().first, cache->relationships.size());
+				cache->relationships.push_back(it.value());
+			}
+			cache->relationship_ids.insert(it.key(), ids.value(it.value().first));
+		}
 
-	//Hash table that binds an edge (a pair of integers) representation to a pair :
-	// 1 its BaseRelationship and 2 its weight
-	QHash<Edge, QPair<BaseRelationship*, int>> edges_hash;
+		//I.2.f	Block-cut tree of the csr graph : each run only keeps the blocks
+		//		between its required tables.
+		updateBlocks();
 
-	//I.2.	Detect connected components
-	auto return_tuple=gqb_p->gqb_c->getConnectedComponents();
-	tables=std::move(get<0>(return_tuple));
-	edges=std::move(get<1>(return_tuple));
-	edges_hash=std::move(get<2>(return_tuple));
+		cache->tables=std::move(tables);
+		cache->tables_r=std::move(tables_r);
+		cache->edges=std::move(edges);
+		cache->edges_hash=std::move(edges_hash);
+		cache->disconnected_vertices=gqb_p->gqb_c->disconnected_vertices;
+		cache->weights_key=weights_key;
+	}
 
-	for (auto it=tables.begin();it!=tables.end();it++)
-		tables_r.insert(it.value(), it.key());
+	//Two lookup containers that are the reverse of each other,
+	//dual-mapping table  object + table number in boost format
+	QHash<BaseTable*, int> &tables=cache->tables;
+	QHash<int, BaseTable*> &tables_r=cache->tables_r;
+
+	//Hash table that binds an edge (a pair of integers) representation to
+	//the id of its BaseRelationship, the relationships and weights being indexed by id
+	QHash<Edge, int> &relationship_ids=cache->relationship_ids;
+	super_res.setRelationships(cache->relationships);
+	super_res.setPathsLimit(gqb_p->paths_limit_sb->value());
+	memory_ceiling=std::size_t(gqb_p->res_mem_budget_sb->value())*1024*1024;
+
+	Graph &g=*cache->graph;
+	GraphMT &gm=*cache->metric;
+	CsrGraph &csr=*cache->csr;
 
 	gqb_p->gqb_c->updateRequiredVertices();
 
@@ -111,144 +225,69 @@ void GraphicalQueryBuilderJoinSolver::findPaths()
 	for(const auto &req_vertex:gqb_p->gqb_c->required_vertices)
 		if(!gqb_p->gqb_c->disconnected_vertices.contains(req_vertex)) nb_required_vertices_connected+=1;
 
-
-	//I.3.	Set relation costs
-	//TODO move to a method
-	vector<int> weights;
-
-	QList<std::tuple<QString, QString, QString, int>> cost_list;
-	if(gqb_p->custom_costs_tw->rowCount()>0)
-		for(int i=0; i<gqb_p->custom_costs_tw->rowCount();i++)
-		{
-			cost_list.push_back(forward_as_tuple(
-						dynamic_cast<QComboBox *>(gqb_p->custom_costs_tw->cellWidget(i,0))->currentText(),
-						dynamic_cast<QComboBox *>(gqb_p->custom_costs_tw->cellWidget(i,1))->currentText(),
-						gqb_p->custom_costs_tw->item(i,2)->text(),
-						gqb_p->custom_costs_tw->item(i,3)->text().toInt()));
-		}
-	QRegExp regexp;
-	regexp.setPatternSyntax(QRegExp::Wildcard);
-
-	int weight;
-	for(auto edge:edges)
-	{
-		Edge reversed_edge=qMakePair<int,int>(edge.second, edge.first);
-
-		//Set default cost...
-		weight=gqb_p->default_cost_sb->value();
-
-		//...add cross-schema extra cost ...
-		if(tables_r.value(edge.first)->getSchema()!=
-			tables_r.value(edge.second)->getSchema())
-				weight+=gqb_p->cross_sch_cost_sb->value();
-
-		//... and custom extra costs.
-		for(const auto &custom_cost:cost_list)
-		{
-			regexp.setPattern(get<2>(custom_cost));
-			auto obj=std::move(get<0>(custom_cost));
-			auto att=std::move(get<1>(custom_cost));
-			if(obj=="Rel")
-			{
-				if(att=="Name")
-				{
-					if(regexp.indexIn(edges_hash.value(edge).first->getName())>=0)
-						weight+=get<3>(custom_cost);
-				}
-				else if(att=="Comment")
-				{
-					if(regexp.indexIn(edges_hash.value(edge).first->getComment())>=0)
-						weight+=get<3>(custom_cost);
-				}
-			}
-			else if(obj=="Constraint")
-			{
-				if(att=="Name")
-				{
-					if(regexp.indexIn(edges_hash.value(edge).first->getReferenceForeignKey()->getName())>=0)
-						weight+=get<3>(custom_cost);
-				}
-				else if(att=="Comment")
-				{
-					if(regexp.indexIn(edges_hash.value(edge).first->getReferenceForeignKey()->getComment())>=0)
-						weight+=get<3>(custom_cost);
-				}
-			}
-			else if (obj=="Table")
-			{
-				if(att=="Name")
-				{
-					if(regexp.indexIn(tables_r.value(edge.first)->getName())>=0 ||
-						regexp.indexIn(tables_r.value(edge.second)->getName())>=0)
-							weight+=get<3>(custom_cost);
-				}
-				else if(att=="Comment")
-				{
-					if(regexp.indexIn(tables_r.value(edge.first)->getComment())>=0 ||
-						regexp.indexIn(tables_r.value(edge.second)->getComment())>=0)
-							weight+=get<3>(custom_cost);
-				}
-			}
-			else if(obj=="Schema")
-			{
-				if(att=="Name")
-				{
-					if(regexp.indexIn(tables_r.value(edge.first)->getSchema()->getName())>=0 ||
-						regexp.indexIn(tables_r.value(edge.second)->getSchema()->getName())>=0)
-							weight+=get<3>(custom_cost);
-				}
-				else if(att=="Comment")
-				{
-					if(regexp.indexIn(tables_r.value(edge.first)->getSchema()->getComment())>=0 ||
-						regexp.indexIn(tables_r.value(edge.second)->getSchema()->getComment())>=0)
-							weight+=get<3>(custom_cost);
-				}
-			}
-		}
-		weights.push_back(weight);
-		for(auto it=edges_hash.begin();it!=edges_hash.end();it++)
-			if(it.key()==edge||it.key()==reversed_edge)
-				it.value().second=weight;
-	}
-
-	// I.4.	Setup the boost graph and its paal metric
-	Graph g(edges.begin(), edges.end(), weights.begin(), tables.size());
-	auto gm = GraphMT(g);
-
 	//-------------------------------------------------------------------------------------------------
-	// II.	Setup Dreyfus Wagner terminals and non-terminals
+	// I.3	Setup Dreyfus Wagner terminals and non-terminals
 	QVector<int> terminals, nonterminals;
+	QBitArray terminal_bits(tables.size());
 	for(const auto &req_vertex:gqb_p->gqb_c->getRequiredVertices())
-		if(!gqb_p->gqb_c->disconnected_vertices.contains(req_vertex)) terminals.push_back(tables.value(req_vertex));
+		if(!gqb_p->gqb_c->disconnected_vertices.contains(req_vertex))
+		{
+			terminals.push_back(tables.value(req_vertex));
+			terminal_bits.setBit(tables.value(req_vertex));
+		}
+
+	// I.4	Blocks of the schema off the ones joining the required tables :
+	//		unrelated subsystems, never entered by a path. Reduced below, they take
+	//		no room in the exact engine nor in its metric.
+	QBitArray discarded_bits=getDiscardedTables(terminal_bits);
+
+	// I.5	Steiner graph reductions : the lookup tables and the chains of tables
+	//		are no steiner points, and the dangling ones are on no path.
+	//		The exact engine runs on the reduced graph, whose super-edges keep the
+	//		distances between the tables left : its trees are the same as on the whole
+	//		graph, their super-edges being expanded into paths on the csr graph.
+	QVector<int> reduced;
+	QBitArray dangling_bits;
+	std::vector<Edge> reduced_edges;
+	std::vector<int> reduced_weights;
+	reduceSteinerGraph(csr, terminal_bits, discarded_bits, reduced, dangling_bits,
+					   reduced_edges, reduced_weights);
+	QBitArray blocked_bits=terminal_bits | dangling_bits;
+
+	QBitArray reduced_bits(tables.size());
+	for(auto vertex:reduced)
+		reduced_bits.setBit(vertex);
 	for(const auto &vertex:tables)
-		if(!terminals.contains(vertex))
+		if(!terminal_bits.testBit(vertex) && !reduced_bits.testBit(vertex))
 			nonterminals.push_back(vertex);
 
-	auto dw = paal::make_dreyfus_wagner(gm, terminals, nonterminals);
-	auto cost_map = dw.get_cost_map();
+	auto &cost_map = gm;
 
 	// TODO Compute the maximum path length for sub-forests
 	// to optimize k+1 shortest path (instead of sp_max_cost_sb UI) ?
 
 	//-------------------------------------------------------------------------------------------------
+	// II.	Run the graph search
 	// II.1.	If only two tables to join...
 	if(nb_required_vertices_connected==2)
 	{
 		int start, goal;
 		start=terminals[0];
 		goal=terminals[1];
-		terminals.pop_back();
 
 		auto edge=qMakePair<int, int>(start, goal);
 		int min_cost=cost_map(start, goal);
 		int extra_budget=(gqb_p->exact_cb->isChecked()? 0 : gqb_p->sp_max_cost_sb->value());
 		int cost=min_cost + extra_budget;
 
-		auto paths=getDetailedPaths(edge, terminals, cost, cost_map,tables,edges_hash, 0, tables_r);
+		//Two simple paths between the same tables never include one another :
+		//the top K paths are the K cheapest ones
+		auto paths=getDetailedPaths(edge, blocked_bits, cost, csr, 0, tables_r,
+									super_res.getPathsLimit());
 		QVector<QPair<QVector<Path>,QVector<QVector<int>>>> paths_wrapper={paths};
 		QVector<int> dummy;
 
-		cartesianProductOnSuperEdges(paths_wrapper,dummy,edges_hash,tables_r, super_res);
+		cartesianProductOnSuperEdges(paths_wrapper,dummy,relationship_ids,tables_r, super_res, super_res_index);
 	}
 
 	/*-------------------------------------------------------------------------------------------------
@@ -259,547 +298,1298 @@ void GraphicalQueryBuilderJoinSolver::findPaths()
 	 */
 	else if(nb_required_vertices_connected>2)
 	{
-		// II.2.a. Initialize containers and run Dreyfus-Wagner once
+		// II.2.a. Initialize containers
 
-		// A sub-result container, stores the two below + path weight.
+		// A sub-result container, stores steiner elements and "super edges" + path weight.
 		// This will be a set of "super-edges", that will further grow into full paths.
+		// Filled by addSteinerTree().
 		QMap< QPair< QVector<int>, QVector<Edge> >, int > dw_results;
-		// A sub-sub-result container, stores steiner elements
-		QVector<int> dw_subresult1;
-		// A sub-sub-result container, stores "super edges"
-		QVector<Edge> dw_subresult2;
 		// A temporary container storing each unique Steiner super-edge,
 		// that will be processed further in II.2.c
 		QMap<Edge,QPair<QVector<Path>,QVector<QVector<int>>>> super_edge_map;
 
-		// Paal's optimal Dreyfus-Wagner algorithm, first call
-		emit s_progressUpdated(Progress_SteinerRound,
-							   1, 0, 0, 0,
-							   0, 0, 0,
-							   0, 0, 0, 0);
-		dw.solve();
-
-		int min_st_cost=dw.get_cost();
+		// II.2.c grow k+1-steiner-tree embryos, all super-edges, into real paths.
+		/*
+		 * Each tree is grown as soon as II.2.b finds it, and the trees come cheapest first :
+		 * the optimal tree and its shortest expansions are the first paths found,
+		 * so a run stopped by its time limit still gives the best ones, the first tree
+		 * found being grown at least into its shortest expansion.
+		 * False once the tree costs the worst kept path or more, as do the next trees.
+		 */
+		int b_a=1;
+		int b_b=1;
+		int extra_budget= (gqb_p->exact_cb->isChecked()? 0 : gqb_p->sp_max_cost_sb->value());
+		QSet<Edge> detailed_super_edges;
 
-		// II.2.b k+1 steiner trees
-		for (auto edge : dw.get_edges())
+		auto expand_tree=[&](int tree_cost, const QPair<QVector<int>, QVector<Edge>> &tree)
 		{
-			Edge qEdge=qMakePair(edge.first, edge.second);
-			if(qEdge.first>qEdge.second)
-				qEdge=qMakePair(qEdge.second, qEdge.first);
+			// Once the top K paths are found, a tree costing their worst cost
+			// or more only gives worse paths, as do the following ones
+			// (sub-paths sharing relationships aside).
+			int cost_bound=super_res.getCostBound();
+			if(stopRequested(b_b==1) || tree_cost>=cost_bound)
+				return false;
+
+			// Sub-paths of the super-edges first met in this tree.
+			// A sub-path costing more than its super-edge by more than the tree's slack
+			// to the bound gives paths over it. The trees come by increasing cost
+			// and the bound only decreases, so the sub-paths of the super-edges
+			// detailed for a previous tree are a superset of the ones needed here.
+			for(const auto &super_edge:tree.second)
+			{
+				if(detailed_super_edges.contains(super_edge))
+					continue;
+				detailed_super_edges.insert(super_edge);
 
-			dw_subresult2.push_back(qEdge);
-			super_edge_map.insert(qEdge,
-				qMakePair<QVector<Path>, QVector<QVector<int>>>(
-					{{qMakePair<int,int>({0},{0})}}, {{0}}));
-		}
-		for (auto se:dw.get_steiner_elements())
-			dw_subresult1.push_back(se);
+				progress->set(GraphicalQueryBuilderProgress::SpCurrent, b_a++);
+				progress->set(GraphicalQueryBuilderProgress::SpCurrentOn, super_edge_map.size());
+				progress->publish(Progress_SuperEdgeRound);
+				int min_cost=cost_map(super_edge.first, super_edge.second);
+				int budget=min_cost+extra_budget;
+				if(cost_bound!=INT_MAX)
+					budget=qMin(budget, cost_bound-1-(tree_cost-min_cost));
 
-		if(!stop_solver_requested && real_time_rendering)
-		{
-			QVector<BaseTable *> dw_srbt1;
-			for(const auto &i:dw_subresult1)
-				dw_srbt1.push_back(tables_r.value(i));
-			emit s_progressTables(PT_SR, dw_srbt1);
-			auto timer=new QTimer(this);
-			timer->setSingleShot(true);
-			timer->start(delay);
-			while(timer->isActive())
-				this_thread->eventDispatcher()->processEvents(QEventLoop::AllEvents);
-		}
+				if(!stop_solver_requested && real_time_rendering)
+					showTables(PT_SP1, {tables_r.value(super_edge.first),tables_r.value(super_edge.second)});
 
-		dw_results.insert(qMakePair< QVector<int>, QVector<Edge> >(dw_subresult1, dw_subresult2),
-						  dw.get_cost());
+				super_edge_map[super_edge]=getDetailedPaths(super_edge, blocked_bits, budget,
+															csr, 1, tables_r);
+			}
 
-		QVector<int> steiners;
-		for(auto a:dw.get_steiner_elements())
-			if(!steiners.contains(a))
-				steiners.push_back(a);
+			if(!stop_solver_requested && real_time_rendering)
+			{
+				QVector<BaseTable *> dw_srbt1;
+				for(const auto &i:tree.first)
+					dw_srbt1.push_back(tables_r.value(i));
+				showTables(PT_FR1, dw_srbt1);
+			}
 
-		bool is_done=false;
-		int c_a=0;
+			if(!stop_solver_requested)
+			{
+				progress->set(GraphicalQueryBuilderProgress::StFRound, b_b++);
+				progress->publish(Progress_FinalRound1);
+			}
+
+			//TODO ? QP<QV,QV> -> QV<QP> to match others
+			QVector<QPair<QVector<Path>,QVector<QVector<int>>>> super_edge_accu;
+			for(auto super_edge:tree.second)
+			{
+				super_edge_accu+=super_edge_map.value(super_edge);
+				//TODO typedefs on datastructures in a namespacefile?
+			}
+			QVector<int> tree_steiners=tree.first;
+			cartesianProductOnSuperEdges(super_edge_accu, tree_steiners, relationship_ids, tables_r, super_res, super_res_index);
+			return true;
+		};
 
 		/*
-		 * This loop is a hack to exlore the search space,
-		 * and make a "k+1 steiner trees algo" not found in academia :
-		 * we recursively run 'Dreyfus-Wagner over all combinations of
-		 * {non-terminals}-{steiner-elements-already-found}'.
-		 * These are incremental power-of-two searches,
-		 * it becomes EXTREMELY expensive really quick.
+		 * II.2.b k+1 steiner trees
+		 * Ranked enumeration of the Steiner trees (Lawler partitioning over Dreyfus-Wagner) :
+		 * each call to next() returns the next cheapest tree, its first call being
+		 * the optimal Dreyfus-Wagner tree. Trees come in non-decreasing cost order,
+		 * so we can stop at the first tree more expensive than the optimum in exact mode,
+		 * or once st_limit_sb trees were found, or once they cost the worst kept path.
 		 */
-		while(!is_done && !stop_solver_requested &&
-			(gqb_p->exact_cb->isChecked() || dw_results.size()<gqb_p->st_limit_sb->value()))
+		progress->set(GraphicalQueryBuilderProgress::StRound, 1);
+		progress->set(GraphicalQueryBuilderProgress::PowN, 0);
+		progress->publish(Progress_SteinerRound);
+
+		QVector<int> steiners;
+
+		// The tables are dense, so their peak size is known before the first run.
+		// The sub-problems promote Steiner tables to terminals, as many as the budget allows.
+		// Only the tables left by the reductions are in them.
+		unsigned engine=gqb_p->st_engine_cmb->currentIndex();
+		size_t dw_vertices_count=terminals.size()+nonterminals.size();
+		auto dw_fits=[&](size_t terminals_count, size_t &memory){
+			memory=KBestDW::memory_usage(terminals_count, dw_vertices_count, gqb_p->dw_threads_sb->value());
+			return terminals_count<=KBestDW::DW::terminals_limit &&
+					memory/(1024*1024)<(size_t)gqb_p->dw_mem_budget_sb->value();
+		};
+		size_t dw_memory, promoted_memory;
+		bool exact_dw=engine==Engine_Exact && dw_fits(terminals.size(), dw_memory);
+		size_t dw_terminals_limit=terminals.size();
+		while(exact_dw && dw_fits(dw_terminals_limit+1, promoted_memory))
+			dw_terminals_limit++;
+
+		if(engine==Engine_Exact)
+		{
+			progress->set(GraphicalQueryBuilderProgress::StMemory, qMin<size_t>(dw_memory, LLONG_MAX));
+			progress->set(GraphicalQueryBuilderProgress::StApproximated, !exact_dw);
+			progress->publish(Progress_SteinerMemory);
+		}
+
+		if(exact_dw)
 		{
-			c_a+=1;
-			emit s_progressUpdated(Progress_SteinerRound,
-								   c_a+1, steiners.size(), 0, 1,
-								   0, 0, 0,
-								   0, 0, 0, 0);
-
-			is_done=true;
-			long long c_b=0;
-
-			auto a=steiners.size();
-			auto b=pow(2,steiners.size());
-			bitset<32> my_bitset;
-			for(int i=0; i<b;i++)
+			//The reduced graph is numbered over the tables left, in tables order, so that
+			//its metric rows only take them. It is kept with the metric rows while the
+			//reductions leave the same tables and super-edges.
+			QVector<int> reduced_numbers(tables.size(), -1);
+			int reduced_count=0;
+			for(int vertex=0; vertex<tables.size(); vertex++)
+				if(!reduced_bits.testBit(vertex))
+					reduced_numbers[vertex]=reduced_count++;
+
+			if(!cache->reduced_metric || cache->reduced_numbers!=reduced_numbers ||
+				cache->reduced_edges!=reduced_edges || cache->reduced_weights!=reduced_weights)
 			{
-				c_b+=1;
-				if(stop_solver_requested ||
-					(!gqb_p->exact_cb->isChecked() && dw_results.size()==gqb_p->st_limit_sb->value()))
-					break;
+				std::vector<Edge> numbered_edges;
+				for(const auto &edge:reduced_edges)
+					numbered_edges.push_back(qMakePair(reduced_numbers[edge.first], reduced_numbers[edge.second]));
+
+				cache->reduced_metric.reset();
+				cache->reduced_graph.reset(new Graph(numbered_edges.begin(), numbered_edges.end(),
+													 reduced_weights.begin(), reduced_count));
+				cache->reduced_metric.reset(new ReducedMetric(*cache->reduced_graph, reduced_numbers,
+															  metric_rows_limit));
+				cache->reduced_numbers=std::move(reduced_numbers);
+				cache->reduced_edges=std::move(reduced_edges);
+				cache->reduced_weights=std::move(reduced_weights);
+			}
 
-				my_bitset=bitset<32>(i);
-				for(int j=0; j<a;j++)
-				{
-					if(my_bitset[j])
-					{
-						if(!dw.m_non_terminals.contains(steiners[j]))
-							dw.m_non_terminals.push_back(steiners[j]);
-					}
-					else
-					{
-							dw.m_non_terminals.removeOne(steiners[j]);
-					}
-				}
-				dw.m_edges.clear();
-				dw.m_steiner_elements.clear();
-				dw.m_best_cand.clear();
-				dw.m_best_split.clear();
+			//On the same graph, the tables of the last run only miss the states of
+			//the newly required tables and kept ones : the first tree is computed from them.
+			if(cache->k_best_dw)
+				updateSteinerVertices(terminals, nonterminals);
+			else
+			{
+				cache->dw_terminals=terminals;
+				cache->dw_nonterminals=nonterminals;
+				cache->k_best_dw.reset(new KBestDW(*cache->reduced_metric, terminals, nonterminals));
+			}
 
-				dw.solve();
+			KBestDW &k_best_dw=*cache->k_best_dw;
+			k_best_dw.restart();
+			k_best_dw.set_terminals_limit(dw_terminals_limit);
+			k_best_dw.set_engine(gqb_p->dw_iterative_cb->isChecked() ?
+									 paal::dreyfus_wagner_engine::iterative :
+									 paal::dreyfus_wagner_engine::recursive);
+			// The threads fill the layers of the first run, then solve the
+			// sub-problems of each branching concurrently.
+			k_best_dw.set_threads_count(gqb_p->dw_threads_sb->value());
+			k_best_dw.set_stop_condition([this](){ return stop_solver_requested.load(); });
+
+			int min_st_cost=-1;
+
+			while(!stop_solver_requested &&
+				(gqb_p->exact_cb->isChecked() || dw_results.size()<gqb_p->st_limit_sb->value()) &&
+				k_best_dw.next())
+			{
+				if(min_st_cost<0)
+					min_st_cost=k_best_dw.get_cost();
+				else if(gqb_p->exact_cb->isChecked() && k_best_dw.get_cost()>min_st_cost)
+					break;
 
-				if(gqb_p->exact_cb->isChecked() && dw.get_cost()>min_st_cost)
-					continue;
+				QVector<int> tree_steiners;
+				for(auto se:k_best_dw.get_steiner_elements())
+					tree_steiners.push_back(se);
 
-				dw_subresult1.clear();
-				dw_subresult2.clear();
-				for (auto edge : dw.get_edges())
-				{
-					Edge qEdge = qMakePair(edge.first, edge.second);
-					dw_subresult2.push_back(qEdge);
+				auto tree=addSteinerTree(k_best_dw.get_edges(), tree_steiners, k_best_dw.get_cost(),
+										 dw_results, super_edge_map, steiners, tables_r);
 
-					super_edge_map.insert(qEdge, qMakePair<QVector<Path>, QVector<QVector<int>>>(
-						{{qMakePair<int,int>({0},{0})}}, {{0}}));
+				if(!stop_solver_requested)
+				{
+					if(dw_results.size()==1)
+					{
+						progress->set(GraphicalQueryBuilderProgress::StCost, min_st_cost);
+						progress->set(GraphicalQueryBuilderProgress::StRatio, 1000);
+						progress->publish(Progress_SteinerBound);
+					}
+					progress->set(GraphicalQueryBuilderProgress::StRound, k_best_dw.get_pending_count());
+					progress->set(GraphicalQueryBuilderProgress::PowN, steiners.size());
+					progress->publish(Progress_SteinerRound);
+					progress->set(GraphicalQueryBuilderProgress::StComb, k_best_dw.get_solved_count());
+					progress->set(GraphicalQueryBuilderProgress::StFound, dw_results.size());
+					progress->publish(Progress_SteinerComb);
 				}
 
-				for (auto se:dw.get_steiner_elements())
-					dw_subresult1.push_back(se);
+				if(tree && !expand_tree(k_best_dw.get_cost(), *tree))
+					break;
 
-				if(!stop_solver_requested && real_time_rendering &&
-				   !dw_results.contains(qMakePair(dw_subresult1, dw_subresult2)))
+				// Still over the memory ceiling once the paths are pruned :
+				// the cheapest trees found are kept
+				if(isOverMemoryCeiling())
 				{
-					QVector<BaseTable *> dw_srbt1;
-					for(const auto &i:dw_subresult1)
-						dw_srbt1.push_back(tables_r.value(i));
-					emit s_progressTables(PT_SR, dw_srbt1);
-					auto timer=new QTimer(this);
-					timer->setSingleShot(true);
-					timer->start(delay);
-					while(timer->isActive())
-						this_thread->eventDispatcher()->processEvents(QEventLoop::AllEvents);
+					memory_pruned=true;
+					reportMemory();
+					break;
 				}
-
-				for(auto a:dw.get_steiner_elements())
-					if(!steiners.contains(a))
-					{
-						steiners.push_back(a);
-						is_done=false;
-					}
-
-				dw_results.insert(qMakePair(dw_subresult1, dw_subresult2), dw.get_cost());
-				if(!stop_solver_requested)
-					emit s_progressUpdated(Progress_SteinerComb,
-										   0, 0, c_b, dw_results.size(),
-										   0, 0, 0,
-										   0, 0, 0, 0);
 			}
-		}
 
-		// II.2.c grow k+1-steiner-tree embryos, all super-edges, into real paths.
-		/*
-		 * Yet another subres container, a reverse of dw_subresults :
-		 * we were interested in path unicity before,
-		 * now with sub-edges we are interested in path weights
-		 * total path weight + weight&edge
-		 */
-		//TODO Make one dw_result : k+1 Steiner trees already spits uniques.
-		QMultiMap<int, QPair< QVector<int>, QVector<Edge> > > dw_results_2;
-		for(auto it=dw_results.begin();it!=dw_results.end();it++)
-			dw_results_2.insert(it.value(), it.key());
-
-		int b_a=1;
-		int extra_budget= (gqb_p->exact_cb->isChecked()? 0 : gqb_p->sp_max_cost_sb->value());
-		for(auto it=super_edge_map.begin();it!=super_edge_map.end();it++)
+			//A run the stop interrupted dropped its tables, or left its enumeration
+			//half branched : the next run starts over.
+			if(stop_solver_requested)
+				cache->k_best_dw.reset();
+		}
+		else
 		{
-			emit s_progressUpdated(Progress_SuperEdgeRound,
-								   0, 0, 0, 0,
-								   b_a++, super_edge_map.size(), 0,
-								   0, 0, 0, 0);
-			int min_cost=cost_map(it.key().first, it.key().second);
-
-			if(!stop_solver_requested && real_time_rendering)
+			// Approximated engine, or too many tables for the exact tables within
+			// the memory budget : one tree in polynomial time, its super-edges being
+			// plain relationships.
+			std::vector<std::pair<int, int>> tree_edges;
+			QVector<int> tree_steiners;
+			int tree_cost;
+			double ratio;
+
+			if(engine==Engine_ShortestPaths)
 			{
-				emit s_progressTables(PT_SP1,{tables_r.value(it.key().first),tables_r.value(it.key().second)});
-				auto timer=new QTimer(this);
-				timer->setSingleShot(true);
-				timer->start(delay);
-				while(timer->isActive())
-					this_thread->eventDispatcher()->processEvents(QEventLoop::AllEvents);
+				auto sp_tree=paal::make_shortest_path_steiner_tree(g, terminals);
+				sp_tree.solve();
+				readApproximatedTree(sp_tree, tree_edges, tree_steiners);
+				tree_cost=sp_tree.get_cost();
+				ratio=sp_tree.get_approximation_ratio();
 			}
-
-			it.value()=getDetailedPaths(it.key(), terminals, min_cost+extra_budget, cost_map,
-										tables, edges_hash, 1, tables_r);
-		}
-
-		// For each Steiner tree
-		int b_b=1;
-		for(auto it=dw_results_2.begin(); it!=dw_results_2.end();it++)
-		{
-			if(!stop_solver_requested && real_time_rendering)
+			else
 			{
-				QVector<BaseTable *> dw_srbt1;
-				for(const auto &i:it.value().first)
-					dw_srbt1.push_back(tables_r.value(i));
-				emit s_progressTables(PT_FR1, dw_srbt1);
-				auto timer=new QTimer(this);
-				timer->setSingleShot(true);
-				timer->start(delay);
-				while(timer->isActive())
-					this_thread->eventDispatcher()->processEvents(QEventLoop::AllEvents);
+				// Voronoi regions and a spanning tree, O(m log n) : the fallback of choice
+				auto mehlhorn_tree=paal::make_mehlhorn_steiner_tree(g, terminals);
+				mehlhorn_tree.solve();
+				readApproximatedTree(mehlhorn_tree, tree_edges, tree_steiners);
+				tree_cost=mehlhorn_tree.get_cost();
+				ratio=mehlhorn_tree.get_approximation_ratio();
 			}
 
-			if(!stop_solver_requested)
-				emit s_progressUpdated(Progress_FinalRound1,
-									   0, 0, 0, 0,
-									   0, 0, 0,
-									   b_b++, 0, 0, 0);
+			auto tree=addSteinerTree(tree_edges, tree_steiners, tree_cost,
+									 dw_results, super_edge_map, steiners, tables_r);
 
-			//TODO ? QP<QV,QV> -> QV<QP> to match others
-			QVector<QPair<QVector<Path>,QVector<QVector<int>>>> super_edge_accu;
-			QVector<QPair<int,int>> candid_full_path;
-			for(auto super_edge:it.value().second)
+			if(!stop_solver_requested)
 			{
-				super_edge_accu+=super_edge_map.value(super_edge);
-				//TODO typedefs on datastructures in a namespacefile?
+				progress->set(GraphicalQueryBuilderProgress::StCost, tree_cost);
+				progress->set(GraphicalQueryBuilderProgress::StRatio, qCeil(ratio*1000));
+				progress->publish(Progress_SteinerBound);
+				progress->set(GraphicalQueryBuilderProgress::StComb, 1);
+				progress->set(GraphicalQueryBuilderProgress::StFound, dw_results.size());
+				progress->publish(Progress_SteinerComb);
 			}
-			cartesianProductOnSuperEdges(super_edge_accu, it.value().first, edges_hash, tables_r, super_res);
+
+			if(tree)
+				expand_tree(tree_cost, *tree);
 		}
 	}
 	//-------------------------------------------------------------------------------------------------
 
-	if(!stop_solver_requested)
+	//Stopped by the time limit : the paths found until then, best first
+	if(!stop_solver_requested || deadline_reached)
+	{
+		super_res.setIncomplete(deadline_reached);
 		emit s_pathsFound(super_res);
+	}
 	else
 		emit s_solverStopped();
 }
 
-QPair<QVector<Path>, QVector<QVector<int>>> GraphicalQueryBuilderJoinSolver::getDetailedPaths(Edge edge,
-								QVector<int> terminals,
-								int cost,
-								CostMap &cost_map,
-								QHash<BaseTable*, int> &tables,
-								QHash<Edge, QPair<BaseRelationship*, int>> &edges_hash,
-								int mode,
-								QHash<int, BaseTable*> &tables_r)
+QVector<GraphicalQueryBuilderJoinSolver::CostRule> GraphicalQueryBuilderJoinSolver::compileCostRules(void)
 {
-	QVector<Path> result;
-	QVector<Edge> branches;
-	QVector<QVector<int>> result_predecessors; //a predecessor "supermap"
-	int start, source, target;
-	int result_size;
-
-	start=edge.first;
-	target=edge.second;
-	source=start;
+	QVector<CostRule> rules;
+	for(int i=0; i<gqb_p->custom_costs_tw->rowCount();i++)
+	{
+		CostRule rule;
+		rule.object=dynamic_cast<QComboBox *>(gqb_p->custom_costs_tw->cellWidget(i,0))->currentIndex();
+		rule.attribute=dynamic_cast<QComboBox *>(gqb_p->custom_costs_tw->cellWidget(i,1))->currentIndex();
+		rule.regexp.setPattern(wildcardToPattern(gqb_p->custom_costs_tw->item(i,2)->text()));
+		rule.regexp.optimize();
+		rule.cost=gqb_p->custom_costs_tw->item(i,3)->text().toInt();
+		rules.push_back(rule);
+	}
+	return rules;
+}
 
-	bool done=false;
+QString GraphicalQueryBuilderJoinSolver::wildcardToPattern(const QString &wildcard)
+{
+	QString pattern;
+	for(int i=0; i<wildcard.size(); i++)
+	{
+		QChar c=wildcard.at(i);
+		if(c=='*')
+			pattern+=".*";
+		else if(c=='?')
+			pattern+='.';
+		else if(c=='[' && wildcard.indexOf(']', i+1)>i+1)
+		{
+			//Sets of characters are kept as is
+			int end=wildcard.indexOf(']', i+1);
+			pattern+=wildcard.mid(i, end-i+1);
+			i=end;
+		}
+		else
+			pattern+=QRegularExpression::escape(QString(c));
+	}
+	return pattern;
+}
 
-	//Step once : find candidate sub-edges, each will start a path
-	for(int i=0;i<tables.size();i++)
+std::vector<int> GraphicalQueryBuilderJoinSolver::computeWeights(const std::vector<Edge> &edges,
+								QHash<int, BaseTable*> &tables_r,
+								QHash<Edge, QPair<BaseRelationship*, int>> &edges_hash)
+{
+	QVector<CostRule> rules=compileCostRules();
+	auto matches=[](const CostRule &rule, BaseObject *object){
+		return rule.regexp.match(rule.attribute==Rule_Name ?
+									 object->getName() : object->getComment()).hasMatch();
+	};
+
+	//The table and schema rules are matched once per table, and per schema :
+	//table_matches[r][t] tells whether the rule r matches the table t.
+	std::vector<std::vector<char>> table_matches(rules.size());
+	for(int r=0; r<rules.size(); r++)
 	{
-			Edge temp_edge=qMakePair<int,int>(source, i);
-			if(i!=source &&
-				cost_map(source,i)+cost_map(i,target)<=cost &&
-				edges_hash.contains(temp_edge) &&
-				cost_map(source, i) == edges_hash.value(temp_edge).second &&
-				(!terminals.contains(i) || i==target))
+		if(rules[r].object!=Rule_Table && rules[r].object!=Rule_Schema)
+			continue;
+
+		QHash<BaseObject *, char> schema_matches;
+		table_matches[r].resize(tables_r.size());
+		for(auto it=tables_r.begin();it!=tables_r.end();it++)
+		{
+			if(rules[r].object==Rule_Table)
+				table_matches[r][it.key()]=matches(rules[r], it.value());
+			else
 			{
-					result.push_back({temp_edge});
-					result_predecessors.push_back({source});
+				BaseObject *schema=it.value()->getSchema();
+				if(!schema_matches.contains(schema))
+					schema_matches.insert(schema, matches(rules[r], schema));
+				table_matches[r][it.key()]=schema_matches.value(schema);
 			}
+		}
+	}
+
+	vector<int> weights;
+	weights.reserve(edges.size());
+	for(const auto &edge:edges)
+	{
+		BaseRelationship *rel=edges_hash.value(edge).first;
+
+		//Set default cost...
+		int weight=gqb_p->default_cost_sb->value();
+
+		//...add cross-schema extra cost ...
+		if(tables_r.value(edge.first)->getSchema()!=
+			tables_r.value(edge.second)->getSchema())
+				weight+=gqb_p->cross_sch_cost_sb->value();
 
+		//... and custom extra costs, the tables and schemas ones once for both ends.
+		for(int r=0; r<rules.size(); r++)
+		{
+			const CostRule &rule=rules[r];
+			bool matched=false;
+			if(rule.object==Rule_Rel)
+				matched=matches(rule, rel);
+			else if(rule.object==Rule_Constraint)
+				matched=rel->getReferenceForeignKey() && matches(rule, rel->getReferenceForeignKey());
+			else
+				matched=table_matches[r][edge.first] || table_matches[r][edge.second];
+
+			if(matched)
+				weight+=rule.cost;
+		}
+
+		//Each relationship is stored both ways
+		weights.push_back(weight);
+		auto it=edges_hash.find(edge);
+		if(it!=edges_hash.end())
+			it.value().second=weight;
+		it=edges_hash.find(qMakePair(edge.second, edge.first));
+		if(it!=edges_hash.end())
+			it.value().second=weight;
 	}
-	result_size=result.size();
 
-	//Traverse all paths that we started, expanding if needed.
-	while(!done)
+	return weights;
+}
+
+bool GraphicalQueryBuilderJoinSolver::updateCache(const QHash<BaseTable*, int> &tables,
+								const std::vector<Edge> &edges,
+								const QHash<Edge, QPair<BaseRelationship*, int>> &edges_hash)
+{
+	//New or lost tables change the numbering
+	if(tables!=cache->tables)
+		return false;
+
+	//Relationships between two tables and their weight, before and now
+	QHash<Edge, int> before, after;
+	for(const auto &edge:cache->edges)
+		before.insert(edge, cache->edges_hash.value(edge).second);
+	for(const auto &edge:edges)
+		after.insert(edge, edges_hash.value(edge).second);
+
+	QVector<Edge> removed, added;
+	for(auto it=before.begin();it!=before.end();it++)
+		if(!after.contains(it.key()) || after.value(it.key())!=it.value())
+			removed.push_back(it.key());
+	for(auto it=after.begin();it!=after.end();it++)
+		if(!before.contains(it.key()) || before.value(it.key())!=it.value())
+			added.push_back(it.key());
+
+	//Relationships both ways between two tables share their boost edges
+	//on removal : left to a rebuild.
+	for(const auto &edge:removed+added)
 	{
-		if(stop_solver_requested)
-			break;
+		Edge reversed_edge=qMakePair<int,int>(edge.second, edge.first);
+		if(before.contains(reversed_edge) || after.contains(reversed_edge))
+			return false;
+	}
+
+	Graph &g=*cache->graph;
+	GraphMT &gm=*cache->metric;
+	for(const auto &edge:removed)
+	{
+		boost::remove_edge(edge.first, edge.second, g);
+		gm.edge_removed(edge.first, edge.second, before.value(edge));
+	}
+	for(const auto &edge:added)
+	{
+		boost::add_edge(edge.first, edge.second, EdgeProp(after.value(edge)), g);
+		gm.edge_added(edge.first, edge.second, after.value(edge));
+	}
+	return true;
+}
 
-		done=true;
-		int r=0;
-		//Step once all paths started
-		while(r<result_size)
+void GraphicalQueryBuilderJoinSolver::updateSteinerVertices(const QVector<int> &terminals,
+															 const QVector<int> &nonterminals)
+{
+	KBestDW &k_best_dw=*cache->k_best_dw;
+	int count=cache->tables.size();
+	std::vector<char> is_terminal(count, false), is_kept(count, false), was_kept(count, false);
+	for(auto vertex:terminals)
+		is_terminal[vertex]=is_kept[vertex]=true;
+	for(auto vertex:nonterminals)
+		is_kept[vertex]=true;
+
+	//The distances of the tables kept are the same on each reduced graph
+	k_best_dw.set_cost_map(*cache->reduced_metric);
+
+	//Tables no longer required become non-terminals, the start one dropping the tables
+	for(int i=cache->dw_terminals.size()-1; i>=0; i--)
+		if(!is_terminal[cache->dw_terminals[i]])
 		{
-			if(stop_solver_requested)
-				break;
+			cache->dw_nonterminals.push_back(cache->dw_terminals[i]);
+			cache->dw_terminals.remove(i);
+			k_best_dw.remove_terminal(i);
+		}
 
-			branches.clear();
-			auto path_to_fill = result[r];
-			auto predecessors_to_fill = result_predecessors[r];
-			auto consumed_cost=0;
-			for(int c=0;c<result[r].size();c++)
-				consumed_cost+=cost_map(result[r][c].first,result[r][c].second);
+	//Non-terminals reduced now leave the tables, dropping the states going through them.
+	//The ones reduced by the last run only join them, keeping all the states : its
+	//reductions left an optimal tree of each of them among the tables it kept, whatever
+	//the other tables, since they only left out dangling tables, chains of tables and
+	//blocks off its terminals.
+	QVector<int> erased, added;
+	for(auto vertex:cache->dw_terminals+cache->dw_nonterminals)
+		was_kept[vertex]=true;
+	for(auto vertex:cache->dw_nonterminals)
+		if(!is_kept[vertex])
+			erased.push_back(vertex);
+	for(auto vertex:terminals+nonterminals)
+		if(!was_kept[vertex])
+			added.push_back(vertex);
+
+	if(!erased.isEmpty())
+		k_best_dw.erase_non_terminals(erased);
+	if(!added.isEmpty())
+		k_best_dw.add_non_terminals(added, true);
+
+	//Newly required tables are non-terminals by now : their states double the tables
+	for(const auto &terminal:terminals)
+		if(!cache->dw_terminals.contains(terminal))
+		{
+			cache->dw_terminals.push_back(terminal);
+			k_best_dw.add_terminal(terminal);
+		}
+	cache->dw_nonterminals=nonterminals;
+}
 
-			source=result[r].last().second;
-			if(source!=target)
-			{
-				//Step this path, the n candidate sub-edges will be put in the branches vector,
-				//and generate n-1 new paths.
-				for(int i=0;i<tables.size();i++)
-				{
-						Edge temp_edge=qMakePair<int,int>(source, i);
-
-						if	(start!=i &&
-							 source!=i &&
-							 !result_predecessors[r].contains(i) &&
-							 cost_map(source,i)+cost_map(i,target)<=cost -consumed_cost &&
-							 edges_hash.contains(temp_edge) &&
-							 cost_map(source, i) == edges_hash.value(temp_edge).second &&
-							 (!terminals.contains(i) || i==target))
-								branches.push_back(temp_edge);
-				}
+void GraphicalQueryBuilderJoinSolver::updateBlocks(void)
+{
+	const CsrGraph &csr=*cache->csr;
+	int count=boost::num_vertices(csr);
 
-				//There can be dead-ends : in such case remove the path embryo
-				if(branches.empty())
+	//Neighbours once each : the parallel relationships and the loops make no block
+	std::vector<QVector<int>> adjacency(count);
+	for(int vertex=0; vertex<count; vertex++)
+	{
+		for(auto edge:boost::make_iterator_range(boost::out_edges(vertex, csr)))
+			if(int(boost::target(edge, csr))!=vertex)
+				adjacency[vertex].push_back(boost::target(edge, csr));
+		std::sort(adjacency[vertex].begin(), adjacency[vertex].end());
+		adjacency[vertex].erase(std::unique(adjacency[vertex].begin(), adjacency[vertex].end()),
+								adjacency[vertex].end());
+	}
+
+	cache->block_tables.clear();
+	cache->table_blocks=QVector<QVector<int>>(count);
+
+	//Iterative depth-first search : once a child's subtree reaches no table above
+	//its parent, the child, the tables stacked since it and the parent are a block.
+	QVector<int> order(count, -1), low(count), stack;
+	QVector<QPair<int, int>> dfs; //table, index of its next neighbour
+	int counter=0;
+	for(int root=0; root<count; root++)
+	{
+		if(order[root]>=0)
+			continue;
+
+		order[root]=low[root]=counter++;
+		stack.push_back(root);
+		dfs.push_back(qMakePair(root, 0));
+		while(!dfs.isEmpty())
+		{
+			int vertex=dfs.last().first;
+			if(dfs.last().second<adjacency[vertex].size())
+			{
+				int neighbour=adjacency[vertex][dfs.last().second++];
+				if(order[neighbour]<0)
 				{
-					result.remove(r);
-					result_predecessors.remove(r);
-					r+=-1;
-					result_size+=-1;
+					order[neighbour]=low[neighbour]=counter++;
+					stack.push_back(neighbour);
+					dfs.push_back(qMakePair(neighbour, 0));
 				}
 				else
+					low[vertex]=qMin(low[vertex], order[neighbour]);
+				continue;
+			}
+
+			dfs.removeLast();
+			if(dfs.isEmpty())
+				break;
+
+			int parent=dfs.last().first;
+			low[parent]=qMin(low[parent], low[vertex]);
+			if(low[vertex]>=order[parent])
+			{
+				QVector<int> block;
+				int table;
+				do
 				{
-					//Add each sub-edge found in its own path
-					//(a new path is inserted each time, from second branch and up)
-					for(const auto &branch:branches)
-					{
-						if(branch==branches[0])
-						{
-							result[r].push_back(branch);
-							result_predecessors[r].push_back(source);
-							if(!stop_solver_requested && real_time_rendering && branch.second==target)
-							{
-								QVector<BaseTable *> btv;
-								for(const auto &i:result_predecessors[r])
-									if(i!=result_predecessors[r].first())
-										btv.push_back(tables_r.value(i));
-								emit s_progressTables(PT_SP2,btv);
-								auto timer=new QTimer(this);
-								timer->setSingleShot(true);
-								timer->start(delay);
-								while(timer->isActive())
-									this_thread->eventDispatcher()->processEvents(QEventLoop::AllEvents);
-							}
-						}
-						else
-						{
-							//Clone the path into a new path...
-							result.insert(r+1,path_to_fill);
-							result_predecessors.insert(r+1,predecessors_to_fill);
-							//... slide counters...
-							r++;
-							result_size++;
-							//... and append the sub-edge
-							result[r].push_back(branch);
-							result_predecessors[r].push_back(source);
-							if(!stop_solver_requested && real_time_rendering && branch.second==target)
-							{
-								QVector<BaseTable *> btv;
-								for(const auto &i:result_predecessors[r])
-									if(i!=result_predecessors[r].first())
-										btv.push_back(tables_r.value(i));
-								emit s_progressTables(PT_SP2,btv);
-								auto timer=new QTimer(this);
-								timer->setSingleShot(true);
-								timer->start(delay);
-								while(timer->isActive())
-									this_thread->eventDispatcher()->processEvents(QEventLoop::AllEvents);
-							}
-						}
-					}
+					table=stack.takeLast();
+					block.push_back(table);
 				}
+				while(table!=vertex);
+				block.push_back(parent);
+
+				for(auto block_table:block)
+					cache->table_blocks[block_table].push_back(cache->block_tables.size());
+				cache->block_tables.push_back(block);
 			}
-			r++;
 		}
-		//Check if we are done
-		for(const auto &path:result)
+		stack.clear();
+	}
+}
+
+QBitArray GraphicalQueryBuilderJoinSolver::getDiscardedTables(const QBitArray &terminal_bits)
+{
+	const QVector<QVector<int>> &block_tables=cache->block_tables, &table_blocks=cache->table_blocks;
+	int count=table_blocks.size();
+
+	//Block-cut tree : the blocks, then a node per articulation point linked to its blocks
+	QVector<QVector<int>> links(block_tables.size());
+	QVector<int> table_node(count, -1);
+	for(int table=0; table<count; table++)
+		if(table_blocks[table].size()>1)
+		{
+			table_node[table]=links.size();
+			links.push_back(table_blocks[table]);
+			for(auto block:table_blocks[table])
+				links[block].push_back(table_node[table]);
+		}
+
+	//The node of each terminal : its articulation point, else its only block
+	QVector<char> required(links.size(), false);
+	for(int table=0; table<count; table++)
+	{
+		if(!terminal_bits.testBit(table))
+			continue;
+		if(table_node[table]>=0)
+			required[table_node[table]]=true;
+		else if(table_blocks[table].size()==1)
+			required[table_blocks[table].first()]=true;
+		else
+			return QBitArray(count);
+	}
+
+	//The leaves of no terminal go until none is left : the subtree spanning the terminals
+	QVector<int> degree(links.size()), pending;
+	QVector<char> pruned(links.size(), false);
+	for(int node=0; node<links.size(); node++)
+	{
+		degree[node]=links[node].size();
+		if(degree[node]<=1 && !required[node])
+			pending.push_back(node);
+	}
+	while(!pending.isEmpty())
+	{
+		int node=pending.takeLast();
+		if(pruned[node])
+			continue;
+		pruned[node]=true;
+		for(auto next:links[node])
+			if(!pruned[next] && --degree[next]<=1 && !required[next])
+				pending.push_back(next);
+	}
+
+	QBitArray discarded_bits(count, true);
+	for(int block=0; block<block_tables.size(); block++)
+		if(!pruned[block])
+			for(auto table:block_tables[block])
+				discarded_bits.clearBit(table);
+	return discarded_bits;
+}
+
+void GraphicalQueryBuilderJoinSolver::reduceSteinerGraph(const CsrGraph &csr, const QBitArray &terminal_bits,
+														 const QBitArray &discarded_bits,
+														 QVector<int> &reduced, QBitArray &dangling_bits,
+														 std::vector<Edge> &reduced_edges,
+														 std::vector<int> &reduced_weights)
+{
+	int count=boost::num_vertices(csr);
+
+	//Neighbours of each table, and the weight of the shortest relationship
+	//or super-edge to each of them, the discarded tables left out
+	std::vector<QHash<int, int>> adjacency(count);
+	for(int vertex=0; vertex<count; vertex++)
+		for(auto edge:boost::make_iterator_range(boost::out_edges(vertex, csr)))
+		{
+			int neighbour=boost::target(edge, csr);
+			int weight=boost::get(boost::edge_weight, csr, edge);
+			if(neighbour==vertex || discarded_bits.testBit(vertex) || discarded_bits.testBit(neighbour))
+				continue;
+			auto itr=adjacency[vertex].find(neighbour);
+			if(itr==adjacency[vertex].end())
+				adjacency[vertex].insert(neighbour, weight);
+			else if(weight<itr.value())
+				itr.value()=weight;
+		}
+
+	//Tables contracted into each super-edge, on its chain or on a longer parallel one
+	QHash<Edge, QVector<int>> chains;
+	auto chain_key=[](int a, int b){ return a<b ? qMakePair(a, b) : qMakePair(b, a); };
+
+	QBitArray removed=discarded_bits;
+	dangling_bits=discarded_bits;
+	reduced.clear();
+	for(int vertex=0; vertex<count; vertex++)
+		if(discarded_bits.testBit(vertex))
+			reduced.push_back(vertex);
+
+	QVector<int> pending;
+	for(int vertex=0; vertex<count; vertex++)
+		if(!removed.testBit(vertex) && !terminal_bits.testBit(vertex) && adjacency[vertex].size()<=2)
+			pending.push_back(vertex);
+
+	while(!pending.isEmpty())
+	{
+		int vertex=pending.takeLast();
+		if(removed.testBit(vertex) || adjacency[vertex].size()>2)
+			continue;
+
+		removed.setBit(vertex);
+		reduced.push_back(vertex);
+		QVector<int> neighbours;
+		for(auto itr=adjacency[vertex].begin(); itr!=adjacency[vertex].end(); itr++)
+		{
+			neighbours.push_back(itr.key());
+			adjacency[itr.key()].remove(vertex);
+		}
+
+		if(neighbours.size()<2)
+		{
+			//Degree 0 or 1 : no simple path between two other tables goes through it,
+			//nor through the tables contracted between it and its neighbour
+			dangling_bits.setBit(vertex);
+			for(auto neighbour:neighbours)
+				for(auto contracted:chains.take(chain_key(vertex, neighbour)))
+					dangling_bits.setBit(contracted);
+		}
+		else
 		{
-			if(path.last().second!=target)
+			//Degree 2 : a-vertex-b becomes the super-edge a-b, kept if shorter than
+			//the one a-b already there, its tables being contracted into it either way
+			int a=neighbours[0], b=neighbours[1];
+			int weight=adjacency[vertex].value(a)+adjacency[vertex].value(b);
+			QVector<int> chain=chains.take(chain_key(a, vertex));
+			chain.push_back(vertex);
+			chain+=chains.take(chain_key(vertex, b));
+			chains[chain_key(a, b)]+=chain;
+
+			auto itr=adjacency[a].find(b);
+			if(itr==adjacency[a].end() || weight<itr.value())
 			{
-				done=false;
-				break;
+				adjacency[a].insert(b, weight);
+				adjacency[b].insert(a, weight);
 			}
 		}
+		adjacency[vertex].clear();
+
+		//Their degree may have dropped
+		for(auto neighbour:neighbours)
+			if(!terminal_bits.testBit(neighbour) && !removed.testBit(neighbour) &&
+					adjacency[neighbour].size()<=2)
+				pending.push_back(neighbour);
+	}
+
+	//Each relationship or super-edge left once, in tables order to be compared between runs
+	reduced_edges.clear();
+	reduced_weights.clear();
+	for(int vertex=0; vertex<count; vertex++)
+	{
+		QList<int> neighbours=adjacency[vertex].keys();
+		std::sort(neighbours.begin(), neighbours.end());
+		for(auto neighbour:neighbours)
+			if(vertex<neighbour)
+			{
+				reduced_edges.push_back(qMakePair(vertex, neighbour));
+				reduced_weights.push_back(adjacency[vertex].value(neighbour));
+			}
+	}
+}
+
+const QPair<QVector<int>, QVector<Edge>> *GraphicalQueryBuilderJoinSolver::addSteinerTree(const std::vector<std::pair<int, int>> &tree_edges,
+								const QVector<int> &tree_steiners, int cost,
+								QMap< QPair< QVector<int>, QVector<Edge> >, int > &dw_results,
+								QMap<Edge,QPair<QVector<Path>,QVector<QVector<int>>>> &super_edge_map,
+								QVector<int> &steiners,
+								QHash<int, BaseTable*> &tables_r)
+{
+	// A sub-sub-result container, stores "super edges"
+	QVector<Edge> dw_subresult2;
+	for (auto edge : tree_edges)
+	{
+		Edge qEdge=qMakePair(edge.first, edge.second);
+		if(qEdge.first>qEdge.second)
+			qEdge=qMakePair(qEdge.second, qEdge.first);
+
+		dw_subresult2.push_back(qEdge);
+		//Not over the sub-paths of a super-edge of a tree already grown
+		if(!super_edge_map.contains(qEdge))
+		{
+			super_edge_map.insert(qEdge,
+				qMakePair<QVector<Path>, QVector<QVector<int>>>(
+					{{qMakePair<int,int>({0},{0})}}, {{0}}));
+			trees_bytes+=sizeof(Edge)+sizeof(QPair<QVector<Path>, QVector<QVector<int>>>);
+		}
+	}
+
+	for (auto se:tree_steiners)
+		if(!steiners.contains(se))
+			steiners.push_back(se);
+
+	if(!stop_solver_requested && real_time_rendering)
+	{
+		QVector<BaseTable *> dw_srbt1;
+		for(const auto &i:tree_steiners)
+			dw_srbt1.push_back(tables_r.value(i));
+		showTables(PT_SR, dw_srbt1);
+	}
+
+	auto key=qMakePair(tree_steiners, dw_subresult2);
+	if(dw_results.contains(key))
+		return nullptr;
+
+	trees_bytes+=sizeof(key)+sizeof(int)+tree_steiners.size()*sizeof(int)+dw_subresult2.size()*sizeof(Edge);
+	reportMemory();
+	return &dw_results.insert(key, cost).key();
+}
+
+QPair<QVector<Path>, QVector<QVector<int>>> GraphicalQueryBuilderJoinSolver::getDetailedPaths(Edge edge,
+								const QBitArray &blocked_bits,
+								int cost,
+								const CsrGraph &csr,
+								int mode,
+								QHash<int, BaseTable*> &tables_r,
+								int max_paths)
+{
+	QVector<Path> result;
+	QVector<QVector<int>> result_predecessors; //a predecessor "supermap"
+	int start, target;
+
+	start=edge.first;
+	target=edge.second;
+
+	//Paths may not cross other terminals, nor dangling tables. The relationships that are not
+	//the shortest way between their two tables were left out of the csr graph.
+	auto vertex_filter=[&blocked_bits](int vertex){
+		return !blocked_bits.testBit(vertex);
+	};
+	auto edge_filter=[](int, int){
+		return true;
+	};
+
+	//Yen's ranked simple paths : they come out by increasing cost,
+	//the enumeration ending at the first one over budget.
+	auto k_shortest_paths=paal::make_k_shortest_simple_paths(csr, start, target, cost,
+															vertex_filter, edge_filter);
+	k_shortest_paths.set_stop_condition([this, &result](){ return stopRequested(result.isEmpty()); });
+
+	//Over the memory ceiling, the cheapest sub-paths found are kept
+	std::size_t result_bytes=0;
+
+	while(!stopRequested(result.isEmpty()) && (max_paths==0 || result.size()<max_paths) &&
+		  k_shortest_paths.next())
+	{
+		const auto &vertices=k_shortest_paths.get_path();
+		Path path;
+		QVector<int> predecessors;
+		for(size_t i=0;i+1<vertices.size();i++)
+		{
+			path.push_back(qMakePair<int,int>(vertices[i], vertices[i+1]));
+			if(i>0)
+				predecessors.push_back(vertices[i]);
+		}
+		result.push_back(path);
+		result_predecessors.push_back(predecessors);
+
+		if(!stop_solver_requested && real_time_rendering)
+		{
+			QVector<BaseTable *> btv;
+			for(const auto &i:predecessors)
+				btv.push_back(tables_r.value(i));
+			showTables(PT_SP2, btv);
+		}
 
 		if(mode==0) //Two tables to join
-			emit s_progressUpdated(Progress_ShortPathMod0,
-								   0, 0, 0,0,
-								   1, 1, (long long)result.size(),
-								   0, 0, 0, (long long)result.size());
+		{
+			progress->set(GraphicalQueryBuilderProgress::SpFound, result.size());
+			progress->set(GraphicalQueryBuilderProgress::PathsFound, result.size());
+			progress->publish(Progress_ShortPathMod0);
+		}
 		else if(mode==1) //... more than two
-			emit s_progressUpdated(Progress_ShortPathMod1,
-								   0, 0, 0, 0,
-								   0, 0, (long long)result.size(),
-								   0, 0, 0, 0 );
+		{
+			progress->set(GraphicalQueryBuilderProgress::SpFound, result.size());
+			progress->publish(Progress_ShortPathMod1);
+		}
+
+		result_bytes+=sizeof(Path)+path.size()*sizeof(Edge)+
+				sizeof(QVector<int>)+predecessors.size()*sizeof(int);
+		if(isOverMemoryCeiling(result_bytes))
+		{
+			memory_pruned=true;
+			break;
+		}
 	}
 
-	for(auto &pre:result_predecessors)
-		pre.pop_front();
+	sub_paths_bytes+=result_bytes;
+	reportMemory();
 
 	return qMakePair<QVector<Path>, QVector<QVector<int>>>(result, result_predecessors);
 
 }
 
 
+void GraphicalQueryBuilderJoinSolver::showTables(int mode, const QVector<BaseTable *> &tables)
+{
+	GraphicalQueryBuilderHighlight highlight;
+	highlight.mode=mode;
+	highlight.tables=tables;
+	highlights->push(highlight);
+}
+
+void GraphicalQueryBuilderJoinSolver::reportMemory(void)
+{
+	progress->set(GraphicalQueryBuilderProgress::ResMemory, paths_bytes+sub_paths_bytes+trees_bytes);
+	progress->set(GraphicalQueryBuilderProgress::ResPruned, memory_pruned);
+	progress->publish(Progress_ResultsMemory);
+}
+
+void GraphicalQueryBuilderJoinSolver::prunePaths(GraphicalQueryBuilderPaths &super_res, PathsIndex &super_res_index)
+{
+	using Word=GraphicalQueryBuilderPaths::Word;
+
+	//The limit also bounds the product : the next paths must be cheaper than the kept ones
+	int limit=qMax(1, super_res.size()*3/4);
+	super_res.setPathsLimit(limit);
+	while(super_res.size()>limit)
+		super_res.removeWorstPath();
+
+	//The index keeps the nodes of the removed sets : rebuilt from the kept paths only
+	std::vector<int> relationships;
+	super_res_index=PathsIndex();
+	for(auto path:super_res.getPathsByCost())
+	{
+		relationships.clear();
+		const Word *bits=super_res.getBits(path);
+		for(int w=0; w<super_res.getWordsCount(); w++)
+			for(Word word=bits[w]; word; word&=word-1)
+				relationships.push_back(w*GraphicalQueryBuilderPaths::WordBits+qCountTrailingZeroBits(word));
+		super_res_index.insert(relationships, path);
+	}
+
+	paths_bytes=super_res.getMemoryUsage()+super_res_index.get_memory_usage();
+	memory_pruned=true;
+}
+
 void GraphicalQueryBuilderJoinSolver::handleJoinSolverStopRequest(void)
 {
 	stop_solver_requested=true;
 }
 
+void GraphicalQueryBuilderJoinSolver::handleJoinSolverDeadline(void)
+{
+	deadline_reached=true;
+	stop_solver_requested=true;
+}
+
 //inspired by
 //https://stackoverflow.com/questions/5279051/how-can-i-create-cartesian-product-of-vector-of-vectors/31169617#31169617
 void GraphicalQueryBuilderJoinSolver::cartesianProductOnSuperEdges(
 		QVector<QPair<QVector<Path>,QVector<QVector<int>>>>& v, // Subpaths + tables involved
 		QVector<int>& steiner_points,
-		QHash<Edge, QPair<BaseRelationship*, int>>& edges_hash,
+		QHash<Edge, int>& relationship_ids,
 		QHash<int, BaseTable*>& tables_r,
-		QMultiMap<int,
-				QPair<QPair<QVector<BaseTable*>, QVector<BaseTable*>>,
-					  QVector<QPair<BaseRelationship*, int>> >>& super_res
+		GraphicalQueryBuilderPaths& super_res,
+		PathsIndex& super_res_index
 		)
 {
+	using Word=GraphicalQueryBuilderPaths::Word;
+	const int words_count=super_res.getWordsCount();
 
 	auto product = [](long long a,
 		QPair<QVector<Path>,QVector<QVector<int>>>& b)
 		{return a*b.second.size();};
 
 	const long long N = accumulate( v.begin(), v.end(), 1LL, product );
-	emit s_progressUpdated(Progress_FinalRound2,
-						   0, 0, 0, 0,
-						   0, 0, 0,
-						   0, 0, N, 0);
+	progress->set(GraphicalQueryBuilderProgress::MultEntryOn, N);
+	progress->publish(Progress_FinalRound2);
 
 	QVector<BaseTable *> steiners_gqb;
 	for(auto steiner_point:steiner_points)
 		steiners_gqb.push_back(tables_r.value(steiner_point));
 
-	for( long long n=0 ; n<N ; ++n )
+	//Relationship bitsets of the sub-paths, computed once : sub-path j of super-edge i
+	//starts at word (sub_path_offsets[i]+j)*words_count.
+	QVector<int> sub_path_offsets;
+	std::vector<Word> sub_path_bits;
+	for(const auto &super_edge:v)
 	{
-		if(stop_solver_requested)
-			break;
-
-		QVector<BaseTable *> involved_tables_gqb;
-		QVector<int> uu;
-		Path vv;
-
-		emit s_progressUpdated(Progress_FinalRound3,
-							   0, 0, 0, 0,
-							   0, 0, 0,
-							   0, n, 0, 0);
-
-		//First cartesian product : on inner tables involved for each super-edge
-		bool candidate_refused=false;
-		lldiv_t q { n, 0 };
-		for( long long i=v.size()-1 ; 0<=i ; --i )
+		sub_path_offsets.push_back(sub_path_bits.size()/std::max(words_count, 1));
+		for(const auto &sub_path:super_edge.first)
 		{
-			q = lldiv( q.quot, v[i].second.size() );
-			uu.append(v[i].second[q.rem]);
+			size_t begin=sub_path_bits.size();
+			sub_path_bits.resize(begin+words_count, 0);
+			for(const auto &edge:sub_path)
+			{
+				int id=relationship_ids.value(edge);
+				sub_path_bits[begin+id/GraphicalQueryBuilderPaths::WordBits]|=
+						Word(1)<<(id%GraphicalQueryBuilderPaths::WordBits);
+			}
 		}
-		std::sort(uu.begin(), uu.end());
-
-		for(auto u:uu)
-			involved_tables_gqb.push_back(tables_r.value(u));
+	}
 
-		// If there is no common intermediate table between all the sub-paths,
-		if(std::adjacent_find(uu.begin(), uu.end())!=uu.end())
-			candidate_refused=true;
-		// and no steiner points in it either...
-		if(candidate_refused) continue;
+	/*
+	 * Depth-first enumeration of the product, one super-edge per depth : the tables
+	 * used so far and the union of the relationships so far are kept along, so a
+	 * sub-path crossing a used table cuts its whole branch, as does a partial path
+	 * already covering a stored path (any full path from it would be refused).
+	 * The super-edges with the fewest sub-paths come first, to cut early.
+	 */
+	const int depth_count=v.size();
+	QVector<int> order;
+	for(int i=0; i<depth_count; i++)
+		order.push_back(i);
+	std::stable_sort(order.begin(), order.end(), [&v](int a, int b){
+		return v[a].second.size()<v[b].second.size();
+	});
+
+	//Number of full paths below a branch of each depth, for the progress
+	std::vector<long long> below(depth_count+1, 1);
+	for(int depth=depth_count-1; depth>=0; depth--)
+		below[depth]=below[depth+1]*v[order[depth]].second.size();
+
+	//Tables that a sub-path may not cross : the steiner points, and the ones used above
+	std::vector<char> used(tables_r.size(), false);
+	for(const auto steiner_point:steiner_points)
+		used[steiner_point]=true;
+
+	//Union of the relationships and cost of the partial path above each depth
+	std::vector<Word> partial_bits(size_t(depth_count+1)*words_count, 0);
+	std::vector<int> partial_costs(depth_count+1, 0);
+	std::vector<Word> added(words_count);
+	long long covered=0;
+
+	//Sorted relationship ids of the partial path above each depth, one segment per
+	//depth in a same buffer : segment d is [ids_begin[d], ids_begin[d+1]). Choosing a
+	//sub-path appends the next segment, the one above merged with the ids it adds, and
+	//backtracking truncates it.
+	std::vector<int> ids, added_ids;
+	std::vector<size_t> ids_begin(depth_count+2, 0);
+
+	//Sub-path tried at each depth, -1 before the first
+	std::vector<int> chosen(depth_count, -1);
+	std::vector<int> relationships;
+	int depth=depth_count>0 ? 0 : -1;
+
+	while(depth>=0)
+	{
+		if(depth==depth_count)
+		{
+			covered++;
+			progress->set(GraphicalQueryBuilderProgress::MultEntry, covered);
+			progress->publish(Progress_FinalRound3);
+			depth--;
+
+			//Deduplicating total paths, and checking for subsets before insertion in result :
+			//no stored path uses a subset of another one's relationships, so a path using
+			//a subset of the candidate's refuses it, otherwise the ones using a superset go.
+			auto path_ids=boost::make_iterator_range(ids.begin()+ids_begin[depth_count], ids.end());
+			if(super_res_index.has_subset(path_ids) || stopRequested(true))
+				continue;
+
+			QVector<int> uu;
+			for(int d=0; d<depth_count; d++)
+				uu+=v[order[d]].second[chosen[d]];
+			std::sort(uu.begin(), uu.end());
+			QVector<BaseTable *> involved_tables_gqb;
+			for(auto u:uu)
+				involved_tables_gqb.push_back(tables_r.value(u));
+
+			const Word *bits=partial_bits.data()+size_t(depth_count)*words_count;
+			super_res_index.remove_supersets(path_ids,
+											 [&super_res](int path){ super_res.removePath(path); });
+			int path=super_res.addPath(bits, partial_costs[depth_count], steiners_gqb, involved_tables_gqb);
+			super_res_index.insert(path_ids, path);
+
+			//Over the limit, the worst path goes out of the index before its slot is reused
+			if(super_res.getPathsLimit()>0 && super_res.size()>super_res.getPathsLimit())
+			{
+				const Word *worst=super_res.getBits(super_res.removeWorstPath());
+				relationships.clear();
+				for(int w=0; w<words_count; w++)
+					for(Word word=worst[w]; word; word&=word-1)
+						relationships.push_back(w*GraphicalQueryBuilderPaths::WordBits+qCountTrailingZeroBits(word));
+				super_res_index.erase(relationships);
+			}
 
-		for(const auto vertex:uu)
-			for(const auto steiner_point:steiner_points)
-				if(vertex==steiner_point)
-					candidate_refused=true;
+			paths_bytes=super_res.getMemoryUsage()+super_res_index.get_memory_usage();
+			if(isOverMemoryCeiling())
+				prunePaths(super_res, super_res_index);
+			reportMemory();
 
-		if(candidate_refused) continue;
-		// ...we have got ourselves a valid full path.
+			if(!stop_solver_requested && real_time_rendering)
+				showTables(PT_FR2, involved_tables_gqb);
 
-		//Second cartesian product : on sub-paths.
-		lldiv_t q2 { n, 0 };
-		for( long long i=v.size()-1 ; 0<=i ; --i )
-		{
-			q2 = lldiv( q2.quot, v[i].second.size() );
-			//Should convert here into gqb format
-			vv.append(v[i].first[q2.rem]);
-		}
-		QVector<QPair<BaseRelationship *, int>> cp_sub_path;
-		//Mapping back to pgm format
-		for(auto edge:vv)
-		{
-			cp_sub_path.push_back(edges_hash.value(edge));
+			progress->set(GraphicalQueryBuilderProgress::PathsFound, super_res.size());
+			progress->publish(Progress_FinalRound4);
+			continue;
 		}
 
-		//Deduplicating total paths, and checking for subsets before insertion in result.
-		candidate_refused=false;
-		auto comp = [](QPair<BaseRelationship *, int> &a,
-						QPair<BaseRelationship *, int> &b)
-			{return a.first<b.first;};
-		std::sort(cp_sub_path.begin(), cp_sub_path.end(), comp);
+		int i=order[depth];
+		const Word *prefix=partial_bits.data()+size_t(depth)*words_count;
+		Word *next=partial_bits.data()+size_t(depth+1)*words_count;
 
-		for(auto it=super_res.begin();it!=super_res.end();it++)
-		{
-			if(stop_solver_requested)
-				break;
+		//Back from the sub-path tried last : its tables are free again
+		if(chosen[depth]>=0)
+			for(const auto table:v[i].second[chosen[depth]])
+				used[table]=false;
 
-			if(std::includes(cp_sub_path.begin(),cp_sub_path.end(),
-							 it.value().second.begin(), it.value().second.end(),comp))
+		int j=chosen[depth]+1;
+		bool found=false;
+		for(; j<v[i].second.size() && !stopRequested(j==0); j++)
+		{
+			//No common intermediate table between the sub-paths, and no steiner points either
+			const auto &inner_tables=v[i].second[j];
+			bool conflict=false;
+			for(const auto table:inner_tables)
+				conflict=conflict || used[table];
+			if(conflict)
 			{
-				candidate_refused=true;
-				break;
+				covered+=below[depth+1];
+				continue;
 			}
-			else if(std::includes(it.value().second.begin(),it.value().second.end(),
-								  cp_sub_path.begin(), cp_sub_path.end(),comp))
+
+			//The relationships it adds, only counted once in the cost
+			const Word *bits=sub_path_bits.data()+size_t(sub_path_offsets[i]+j)*words_count;
+			added_ids.clear();
+			for(int w=0; w<words_count; w++)
 			{
-				super_res.remove(it.key(),it.value());
+				added[w]=bits[w] & ~prefix[w];
+				next[w]=prefix[w] | bits[w];
+				for(Word word=added[w]; word; word&=word-1)
+					added_ids.push_back(w*GraphicalQueryBuilderPaths::WordBits+qCountTrailingZeroBits(word));
 			}
-		}
+			partial_costs[depth+1]=partial_costs[depth]+super_res.getWeight(added.data());
 
-		if(!candidate_refused && !stop_solver_requested)
-		{
-			int cost=0;
-			for(const auto edge:cp_sub_path)
-				cost+=edge.second;
+			//The partial cost only grows : past the worst of the top K paths, no path below
+			if(partial_costs[depth+1]>=super_res.getCostBound())
+			{
+				covered+=below[depth+1];
+				continue;
+			}
 
-			super_res.insert(cost, qMakePair(qMakePair(steiners_gqb, involved_tables_gqb), cp_sub_path));
+			//Reserved first, so that the merge reads the segment above in place
+			size_t begin=ids_begin[depth], end=ids_begin[depth+1];
+			ids.resize(end);
+			ids.reserve(end+(end-begin)+added_ids.size());
+			std::merge(ids.begin()+begin, ids.begin()+end, added_ids.begin(), added_ids.end(),
+					   std::back_inserter(ids));
+			ids_begin[depth+2]=ids.size();
 
-			if(!stop_solver_requested && real_time_rendering)
+			if(depth+1<depth_count &&
+				super_res_index.has_subset(boost::make_iterator_range(ids.begin()+end, ids.end())))
 			{
-				emit s_progressTables(PT_FR2, involved_tables_gqb);
-				auto timer=new QTimer(this);
-				timer->setSingleShot(true);
-				timer->start(delay);
-				while(timer->isActive())
-					this_thread->eventDispatcher()->processEvents(QEventLoop::AllEvents);
+				covered+=below[depth+1];
+				continue;
 			}
+			found=true;
+			break;
+		}
 
-			emit s_progressUpdated(Progress_FinalRound4,
-								   0, 0, 0, 0,
-								   0, 0, 0,
-								   0, 0, 0, (long long)super_res.size());
+		//Every sub-path tried, or the run stopped : back to the depth above
+		if(!found)
+		{
+			chosen[depth]=-1;
+			depth--;
+			continue;
 		}
+
+		chosen[depth]=j;
+		for(const auto table:v[i].second[j])
+			used[table]=true;
+		depth++;
+	}
+}
+
+void GraphicalQueryBuilderPaths::setRelationships(const QVector<QPair<BaseRelationship*, int>> &rels)
+{
+	relationships=rels;
+	words_count=(rels.size()+WordBits-1)/WordBits;
+	alive_count=0;
+	serials_count=0;
+	path_tables_count=0;
+	bits.clear();
+	costs.clear();
+	removed.clear();
+	tables.clear();
+	serials.clear();
+	free_paths.clear();
+	worst_paths=std::priority_queue<HeapEntry>();
+}
+
+void GraphicalQueryBuilderPaths::setPathsLimit(int limit)
+{
+	//Without a limit the heap is not kept : the paths enter it now
+	if(limit>0 && paths_limit<=0)
+	{
+		for(int path=0; path<int(costs.size()); path++)
+			if(!removed[path])
+				worst_paths.push(HeapEntry(costs[path], serials[path], path));
+	}
+	paths_limit=limit;
+}
+
+int GraphicalQueryBuilderPaths::getCostBound(void) const
+{
+	if(paths_limit<=0 || alive_count<paths_limit || worst_paths.empty())
+		return INT_MAX;
+	return std::get<0>(worst_paths.top());
+}
+
+int GraphicalQueryBuilderPaths::addPath(const Word *bitset, int cost,
+										const QVector<BaseTable*> &steiners, const QVector<BaseTable*> &path_tables)
+{
+	int path;
+	if(!free_paths.empty())
+	{
+		//Reuses the slot of a removed path
+		path=free_paths.back();
+		free_paths.pop_back();
+		std::copy(bitset, bitset+words_count, bits.begin()+std::size_t(path)*words_count);
+		costs[path]=cost;
+		removed[path]=false;
+		tables[path]=qMakePair(steiners, path_tables);
+		serials[path]=serials_count;
+	}
+	else
+	{
+		path=costs.size();
+		bits.insert(bits.end(), bitset, bitset+words_count);
+		costs.push_back(cost);
+		removed.push_back(false);
+		tables.push_back(qMakePair(steiners, path_tables));
+		serials.push_back(serials_count);
+	}
+	if(paths_limit>0)
+		worst_paths.push(HeapEntry(cost, serials_count, path));
+	serials_count++;
+	alive_count++;
+	path_tables_count+=steiners.size()+path_tables.size();
+	return path;
+}
+
+void GraphicalQueryBuilderPaths::removePath(int path)
+{
+	if(removed[path])
+		return;
+	removed[path]=true;
+	path_tables_count-=tables[path].first.size()+tables[path].second.size();
+	tables[path]=QPair<QVector<BaseTable*>, QVector<BaseTable*>>();
+	free_paths.push_back(path);
+	alive_count--;
+	dropRemovedWorstPaths();
+}
+
+int GraphicalQueryBuilderPaths::removeWorstPath(void)
+{
+	if(worst_paths.empty())
+		return -1;
+	int path=std::get<2>(worst_paths.top());
+	removePath(path);
+	return path;
+}
+
+void GraphicalQueryBuilderPaths::dropRemovedWorstPaths(void)
+{
+	//An entry is stale once its path is removed, or its slot holds a later path
+	while(!worst_paths.empty())
+	{
+		const HeapEntry &top=worst_paths.top();
+		int path=std::get<2>(top);
+		if(!removed[path] && serials[path]==std::get<1>(top))
+			break;
+		worst_paths.pop();
 	}
 }
+
+std::size_t GraphicalQueryBuilderPaths::getMemoryUsage(void) const
+{
+	//The slots of the removed paths are reused : only the kept ones are counted
+	std::size_t path_bytes=words_count*sizeof(Word)+sizeof(int)+sizeof(char)+sizeof(long long)+
+			sizeof(QPair<QVector<BaseTable*>, QVector<BaseTable*>>)+
+			(paths_limit>0 ? sizeof(HeapEntry) : 0);
+	return alive_count*path_bytes+path_tables_count*sizeof(BaseTable*);
+}
+
+QVector<QPair<BaseRelationship*, int>> GraphicalQueryBuilderPaths::getRelationships(int path) const
+{
+	QVector<QPair<BaseRelationship*, int>> result;
+	const Word *bitset=getBits(path);
+	result.reserve(countBits(bitset, words_count));
+	for(int w=0; w<words_count; w++)
+		for(Word word=bitset[w]; word; word&=word-1)
+			result.push_back(relationships[w*WordBits+qCountTrailingZeroBits(word)]);
+	return result;
+}
+
+QVector<int> GraphicalQueryBuilderPaths::getPathsByCost(void) const
+{
+	QVector<int> result;
+	result.reserve(alive_count);
+	for(int path=0; path<(int)costs.size(); path++)
+		if(!removed[path])
+			result.push_back(path);
+	//Slots are reused, so the insertion order is the serials one
+	std::sort(result.begin(), result.end(), [this](int a, int b){
+		return costs[a]<costs[b] || (costs[a]==costs[b] && serials[a]<serials[b]);
+	});
+	return result;
+}
+
+int GraphicalQueryBuilderPaths::getWeight(const Word *bitset) const
+{
+	int weight=0;
+	for(int w=0; w<words_count; w++)
+		for(Word word=bitset[w]; word; word&=word-1)
+			weight+=relationships[w*WordBits+qCountTrailingZeroBits(word)].second;
+	return weight;
+}
+
+int GraphicalQueryBuilderPaths::countBits(const Word *bitset, int words_count)
+{
+	int count=0;
+	for(int w=0; w<words_count; w++)
+		count+=qPopulationCount(bitset[w]);
+	return count;
+}
@@ -30,64 +30,459 @@
 #include "basetable.h"
 #include "baserelationship.h"
 #include "paal/data_structures/metric/graph_metrics.hpp"
+#include "paal/data_structures/metric/lazy_graph_metric.hpp"
+#include "paal/data_structures/set_trie.hpp"
 #include "paal/steiner_tree/dreyfus_wagner.hpp"
+#include "paal/steiner_tree/k_best_dreyfus_wagner.hpp"
+#include "paal/steiner_tree/shortest_path_steiner_tree.hpp"
+#include "paal/steiner_tree/mehlhorn_steiner_tree.hpp"
+#include "paal/utils/k_shortest_simple_paths.hpp"
+#include <boost/graph/compressed_sparse_row_graph.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <QBitArray>
 #include <QMetaType>
+#include <QRegularExpression>
+#include <atomic>
+#include <memory>
+#include <queue>
+#include <tuple>
+#include <vector>
 
-//! \brief This needs registration to get communicated as argument between threads.
-typedef QMultiMap<int,
-QPair<
-	  QPair<QVector<BaseTable*>, QVector<BaseTable*>>,
-	  QVector<QPair<BaseRelationship*, int>
->>> paths;
 typedef QVector<BaseTable *> bts;
 
+//! \brief A highlight of the real-time rendering : the PT_ mode and its tables
+struct GraphicalQueryBuilderHighlight {
+	int mode;
+	QVector<BaseTable *> tables;
+};
+
+//! \brief Highlights pushed by the solver thread and drawn by the pathwidget at its own
+//! pace. Bounded : the highlights pushed when it is full are dropped.
+using GraphicalQueryBuilderHighlights = boost::lockfree::spsc_queue<GraphicalQueryBuilderHighlight>;
+
+/**
+\ingroup plugins/graphicalquerybuilder
+\class GraphicalQueryBuilderPaths
+\brief Paths found by the join solver. The relationships are interned to dense ids,
+	and each path is a bitset over them, all the paths sharing one flat arena : building,
+	counting and reading paths are word-wise operations, without allocations.
+	The relationship objects are only looked up when the paths are displayed.
+	With a paths limit, only the cheapest paths are kept : a max-heap on the costs gives
+	the worst one, evicted once the limit is exceeded, and its slot is reused.
+	A run stopped by its time limit gives the paths found until then, marked incomplete.
+	The memory of the kept paths is counted as they are added and removed.
+	This needs registration to get communicated as argument between threads.
+*/
+class GraphicalQueryBuilderPaths {
+	public:
+		using Word = quint64;
+		static constexpr int WordBits = 64;
+
+		GraphicalQueryBuilderPaths(void) : words_count(0), alive_count(0), paths_limit(0), serials_count(0),
+			path_tables_count(0), incomplete(false) {}
+
+		//! \brief Sets the relationships and their weight, the id of each being its index.
+		//! Clears the paths.
+		void setRelationships(const QVector<QPair<BaseRelationship*, int>> &rels);
+
+		//! \brief Number of words of a path bitset
+		int getWordsCount(void) const { return words_count; }
+
+		//! \brief Number of paths kept at most, 0 for no limit.
+		//! May be set once paths are stored : they enter the heap on the first limit.
+		void setPathsLimit(int limit);
+		int getPathsLimit(void) const { return paths_limit; }
+
+		//! \brief Marks the paths of a run stopped by its time limit
+		void setIncomplete(bool value) { incomplete=value; }
+		bool isIncomplete(void) const { return incomplete; }
+
+		//! \brief Cost a path must be under to be kept : the worst kept cost
+		//! once the limit is reached, INT_MAX otherwise
+		int getCostBound(void) const;
+
+		//! \brief Stores a path given as getWordsCount() words, returns its index.
+		//! The index of a removed path may be reused.
+		int addPath(const Word *bits, int cost,
+					const QVector<BaseTable*> &steiners, const QVector<BaseTable*> &tables);
+
+		//! \brief Removes a path
+		void removePath(int path);
+
+		//! \brief Removes the path of the worst cost, the last inserted among the equals,
+		//! and returns its index. Its bits stay readable until the next addPath().
+		int removeWorstPath(void);
+
+		bool isRemoved(int path) const { return removed[path]; }
+
+		//! \brief Number of paths not removed
+		int size(void) const { return alive_count; }
+
+		const Word *getBits(int path) const { return bits.data()+std::size_t(path)*words_count; }
+
+		int getCost(int path) const { return costs[path]; }
+
+		//! \brief Steiner points, and non-terminal non-steiner tables of a path
+		const QVector<BaseTable*> &getSteiners(int path) const { return tables[path].first; }
+		const QVector<BaseTable*> &getTables(int path) const { return tables[path].second; }
+
+		//! \brief Relationships of a path and their weight, by id
+		QVector<QPair<BaseRelationship*, int>> getRelationships(int path) const;
+
+		//! \brief Paths not removed, by cost then in insertion order
+		QVector<int> getPathsByCost(void) const;
+
+		//! \brief Sum of the weights of the relationships set in the bitset
+		int getWeight(const Word *bitset) const;
+
+		//! \brief Approximate bytes of the kept paths : their bits, costs, tables and heap entries
+		std::size_t getMemoryUsage(void) const;
+
+		//! \brief Number of bits set, one popcount per word
+		static int countBits(const Word *bitset, int words_count);
+
+	private:
+		//! \brief Cost, insertion serial, index
+		using HeapEntry = std::tuple<int, long long, int>;
+
+		QVector<QPair<BaseRelationship*, int>> relationships;
+		int words_count, alive_count, paths_limit;
+		long long serials_count;
+
+		//! \brief Steiner points and tables of the kept paths
+		long long path_tables_count;
+		bool incomplete;
+
+		std::vector<Word> bits;
+		std::vector<int> costs;
+		std::vector<char> removed;
+		std::vector<QPair<QVector<BaseTable*>, QVector<BaseTable*>>> tables;
+		std::vector<long long> serials;
+		std::vector<int> free_paths;
+
+		//! \brief Max-heap of the kept paths, the entries of the removed ones being
+		//! dropped when they reach the top : the top is always a kept path
+		std::priority_queue<HeapEntry> worst_paths;
+
+		void dropRemovedWorstPaths(void);
+};
+
+
+/**
+\ingroup plugins/graphicalquerybuilder
+\class GraphicalQueryBuilderProgress
+\brief Progress of a solver run. The solver stores the counters and marks the
+	reports (the Progress_ aliases) they belong to, without any event : the status tab
+	polls them at a fixed rate and refreshes the reports marked since its last poll.
+	The stores are relaxed, and a report is only marked again once polled.
+*/
+class GraphicalQueryBuilderProgress {
+	public:
+		//! \brief Counters, named after the status tab labels
+		static constexpr unsigned
+			StRound=0,			//k+1-Steiner pending sub-problems
+			PowN=1,				//k+1-Steiner steiner points
+			StComb=2,			//k+1-Steiner sub-problems solved
+			StFound=3,			//k+1-Steiner trees found
+			StMemory=4,			//k+1-Steiner tables memory, bytes
+			StApproximated=5,	//the tables were over budget : approximated tree
+			StCost=6,			//Steiner tree cost
+			StRatio=7,			//its approximation bound, per mille
+			SpCurrent=8,		//super-edge round
+			SpCurrentOn=9,		//super-edges
+			SpFound=10,			//sub-paths found
+			StFRound=11,		//multiplication round, per tree
+			MultEntry=12,		//products covered
+			MultEntryOn=13,		//products of the tree
+			PathsFound=14,		//paths found
+			ResMemory=15,		//result containers memory, bytes
+			ResPruned=16,		//the containers were over the ceiling : pruned
+			CountersCount=17;
+
+		GraphicalQueryBuilderProgress(void) { reset(); }
+
+		void set(unsigned counter, long long value) {
+			counters[counter].store(value, std::memory_order_relaxed);
+		}
+
+		long long get(unsigned counter) const {
+			return counters[counter].load(std::memory_order_relaxed);
+		}
+
+		//! \brief Marks a report for the next poll, its counters being set
+		void publish(unsigned mode) {
+			unsigned bit=1u<<mode;
+			if(!(updated.load(std::memory_order_relaxed) & bit))
+				updated.fetch_or(bit, std::memory_order_release);
+		}
+
+		//! \brief Reports marked since the last call, one bit per Progress_ alias
+		unsigned takeUpdated(void) {
+			return updated.exchange(0, std::memory_order_acquire);
+		}
+
+		void reset(void) {
+			for(auto &counter:counters)
+				counter.store(0, std::memory_order_relaxed);
+			updated.store(0, std::memory_order_release);
+		}
+
+	private:
+		std::atomic<long long> counters[CountersCount];
+		std::atomic<unsigned> updated;
+};
+
 
 class GraphicalQueryBuilderPathWidget;
 
+/**
+\ingroup plugins/graphicalquerybuilder
+\class GraphicalQueryBuilderSolverCache
+\brief Solver setup kept between the runs on a same model : the tables numbering,
+	the relationship weights, the graph and its metric rows, its block-cut tree.
+	The path widget keeps one per model widget.
+*/
+class GraphicalQueryBuilderSolverCache {
+	public:
+		//Aliases for boost and paal structures.
+		using EdgeProp = boost::property<boost::edge_weight_t, int>;
+		using Graph = boost::adjacency_list<
+			boost::vecS, boost::vecS, boost::undirectedS,
+			boost::property<boost::vertex_color_t, int>, EdgeProp>;
+		using Edge = QPair<int, int>;
+		using GraphMT = paal::data_structures::lazy_graph_metric<Graph, int>;
+		//! \brief Path expansion graph : weight and relationship of each edge,
+		//! stored with the edges in their source order.
+		using CsrEdgeProp = boost::property<boost::edge_weight_t, int,
+				boost::property<boost::edge_name_t, BaseRelationship*>>;
+		using CsrGraph = boost::compressed_sparse_row_graph<
+			boost::directedS, boost::no_property, CsrEdgeProp, boost::no_property, int, int>;
+
+		//! \brief Metric of a reduced graph numbered over the tables it keeps, read with
+		//! the tables numbers : its rows only take the tables kept.
+		class ReducedMetric {
+			public:
+				using VertexType = int;
+				using DistanceType = int;
+
+				ReducedMetric(const Graph &graph, const QVector<int> &numbers, std::size_t rows_limit) :
+					metric(graph, rows_limit), numbers(numbers) {}
+
+				int operator()(int u, int v) const { return metric(numbers[u], numbers[v]); }
+
+			private:
+				GraphMT metric;
+
+				//! \brief Number of each table in the reduced graph, -1 if left out
+				QVector<int> numbers;
+		};
+
+		//! \brief 64 bits masks : past that, the exact tables could not fit anyway.
+		using KBestDW = paal::k_best_dreyfus_wagner<ReducedMetric, QVector<int>, QVector<int>, 64>;
+
+		//! \brief Set from the GUI thread on model edits : the next run compares
+		//! the model with the cache instead of reusing it as is.
+		std::atomic<bool> model_changed;
+
+		//! \brief Cost parameters the weights were computed with
+		QString weights_key;
+
+		//! \brief Same containers as in findPaths()
+		QHash<BaseTable*, int> tables;
+		QHash<int, BaseTable*> tables_r;
+		std::vector<Edge> edges;
+		QHash<Edge, QPair<BaseRelationship*, int>> edges_hash;
+		QVector<BaseTable *> disconnected_vertices;
+
+		//! \brief Dense relationship ids : the relationship and weight of each id,
+		//! and the id of each edge, both ways.
+		QVector<QPair<BaseRelationship*, int>> relationships;
+		QHash<Edge, int> relationship_ids;
+
+		//! \brief The metric refers to the graph, hence both on the heap.
+		std::unique_ptr<Graph> graph;
+		std::unique_ptr<GraphMT> metric;
+		std::unique_ptr<CsrGraph> csr;
+
+		//! \brief Block-cut tree of the csr graph : the tables of each biconnected block,
+		//! and the blocks of each table, several for an articulation point
+		QVector<QVector<int>> block_tables, table_blocks;
+
+		//! \brief Reduced graph of the last exact run and its metric, from the relationships
+		//! and super-edges left by the Steiner reductions : the number of each table in it,
+		//! -1 for the reduced ones, and its edges on the tables numbers
+		QVector<int> reduced_numbers;
+		std::vector<Edge> reduced_edges;
+		std::vector<int> reduced_weights;
+		std::unique_ptr<Graph> reduced_graph;
+		std::unique_ptr<ReducedMetric> reduced_metric;
+
+		//! \brief Exact engine of the last run on the reduced graph, its terminals in its
+		//! order and its non-terminals : its first run's tables are extended or shrunk on
+		//! the next run when only the required tables changed. Dropped whenever the metric
+		//! is rebuilt.
+		QVector<int> dw_terminals, dw_nonterminals;
+		std::unique_ptr<KBestDW> k_best_dw;
+
+		GraphicalQueryBuilderSolverCache(void) : model_changed(true) {}
+};
+
 class GraphicalQueryBuilderJoinSolver: public QObject{
 
 	//Aliases for boost and paal structures.
-	using EdgeProp = boost::property<boost::edge_weight_t, int>;
-	using Graph = boost::adjacency_list<
-		boost::vecS, boost::vecS, boost::undirectedS,
-		boost::property<boost::vertex_color_t, int>, EdgeProp>;
+	using EdgeProp = GraphicalQueryBuilderSolverCache::EdgeProp;
+	using Graph = GraphicalQueryBuilderSolverCache::Graph;
 	using Edge = QPair<int, int>;
-	using GraphMT = paal::data_structures::graph_metric<Graph, int>;
+	using GraphMT = GraphicalQueryBuilderSolverCache::GraphMT;
+	using ReducedMetric = GraphicalQueryBuilderSolverCache::ReducedMetric;
 	using Terminals = std::vector<int>;
 	using edge_parallel_category = boost::allow_parallel_edge_tag;
 	using CostMap=paal::data_structures::graph_metric<Graph,
 			int, paal::data_structures::graph_type::sparse_tag>;
 	using Path = QVector<Edge>;
+	using CsrEdgeProp = GraphicalQueryBuilderSolverCache::CsrEdgeProp;
+	using CsrGraph = GraphicalQueryBuilderSolverCache::CsrGraph;
+	using KBestDW = GraphicalQueryBuilderSolverCache::KBestDW;
+	//! \brief Relationship id sets of the paths found, to their index
+	using PathsIndex = paal::data_structures::set_trie<int, int>;
 
 	private:
 		Q_OBJECT
 
-		QThread *this_thread;
 		bool real_time_rendering;
-		int delay;
 
 		GraphicalQueryBuilderPathWidget *gqb_p;
 
-		//! \brief Indicates if the solver run was stopped by the user
-		bool stop_solver_requested;
+		//! \brief Setup of the previous runs on the model
+		GraphicalQueryBuilderSolverCache *cache;
+
+		//! \brief Progress counters, polled by the pathwidget status tab
+		GraphicalQueryBuilderProgress *progress;
+
+		//! \brief Real-time rendering highlights, drawn by the pathwidget
+		GraphicalQueryBuilderHighlights *highlights;
+
+		//! \brief Queues a highlight for the real-time rendering, never waiting :
+		//! dropped if the pathwidget is behind.
+		void showTables(int mode, const QVector<BaseTable *> &tables);
+
+		//! \brief Metric rows kept at once, each one a Dijkstra from a table.
+		static constexpr unsigned metric_rows_limit=256;
+
+		//! \brief Indicates if the solver run was stopped by the user,
+		//! set from the GUI thread and read by the solver threads.
+		std::atomic<bool> stop_solver_requested;
+
+		//! \brief Indicates if the run was stopped by its time limit, set before
+		//! stop_solver_requested : the paths found until then are still given.
+		std::atomic<bool> deadline_reached;
+
+		//! \brief Whether a stage must stop. Past the time limit, a stage still completes
+		//! its first result : the shortest sub-path of a super-edge, the first branch of
+		//! the product, so that the tree being grown gives its shortest expansion.
+		bool stopRequested(bool first_result) const
+		{ return stop_solver_requested && !(first_result && deadline_reached); }
+
+		//! \brief Approximate bytes of the result containers of the run : the kept paths
+		//! and their index, the sub-paths of the super-edges, the Steiner trees
+		std::size_t paths_bytes, sub_paths_bytes, trees_bytes;
+
+		//! \brief Bytes the result containers may use, 0 for no limit
+		std::size_t memory_ceiling;
+
+		//! \brief Indicates if the containers were pruned to stay under the ceiling
+		bool memory_pruned;
+
+		//! \brief Whether the result containers, and extra bytes about to be added,
+		//! are over the ceiling
+		bool isOverMemoryCeiling(std::size_t extra=0) const
+		{ return memory_ceiling>0 && paths_bytes+sub_paths_bytes+trees_bytes+extra>memory_ceiling; }
+
+		//! \brief Publishes the result containers memory to the status tab
+		void reportMemory(void);
+
+		//! \brief Once over the ceiling, keeps the cheapest three quarters of the paths,
+		//! the rest bounded by them, and rebuilds their index without the removed ones.
+		void prunePaths(GraphicalQueryBuilderPaths &super_res, PathsIndex &super_res_index);
+
+		//! \brief A custom cost row, its wildcard compiled once
+		struct CostRule {
+			unsigned object, attribute;
+			QRegularExpression regexp;
+			int cost;
+		};
+
+		//! \brief Reads and compiles the custom cost rows
+		QVector<CostRule> compileCostRules(void);
+
+		//! \brief Regular expression searching the wildcard anywhere in a text,
+		//! as QRegExp::Wildcard and indexIn() did
+		static QString wildcardToPattern(const QString &wildcard);
+
+		//! \brief Relationship costs : default, cross-schema and custom costs.
+		//! Also stores them in edges_hash.
+		std::vector<int> computeWeights(const std::vector<Edge> &edges,
+										QHash<int, BaseTable*> &tables_r,
+										QHash<Edge, QPair<BaseRelationship*, int>> &edges_hash);
+
+		//! \brief Applies the relationships added, removed or reweighted since the
+		//! cached run to the cached graph and metric, only dropping the metric rows
+		//! they affect. False if the tables changed : the cache must be rebuilt.
+		bool updateCache(const QHash<BaseTable*, int> &tables,
+						 const std::vector<Edge> &edges,
+						 const QHash<Edge, QPair<BaseRelationship*, int>> &edges_hash);
+
+		//! \brief Adds and removes the cached exact engine's terminals and non-terminals
+		//! until they are the given ones, new terminals last, and moves it to the
+		//! reduced graph of the run.
+		void updateSteinerVertices(const QVector<int> &terminals, const QVector<int> &nonterminals);
+
+		//! \brief Biconnected blocks of the cached csr graph (Hopcroft-Tarjan),
+		//! the tables in several of them being its articulation points
+		void updateBlocks(void);
+
+		//! \brief Tables of the blocks off the subtree of the block-cut tree spanning
+		//! the terminals : no path between two terminals goes through them.
+		QBitArray getDiscardedTables(const QBitArray &terminal_bits);
+
+		//! \brief Steiner reductions of the csr graph, whose relationships longer than the
+		//! shortest way between their tables were left out : the non-terminals of degree 1
+		//! go, and the ones of degree 2 are contracted into super-edges, until none is left.
+		//! The discarded tables are left out first.
+		//! Gives the non-terminals reduced, never steiner points, and among them the
+		//! dangling ones, on no path between two tables left. Also gives the reduced
+		//! graph : the shortest relationship or super-edge between two tables left.
+		void reduceSteinerGraph(const CsrGraph &csr, const QBitArray &terminal_bits,
+								const QBitArray &discarded_bits,
+								QVector<int> &reduced, QBitArray &dangling_bits,
+								std::vector<Edge> &reduced_edges, std::vector<int> &reduced_weights);
+
+		//! \brief Stores one Steiner tree as super-edges for the path expansion,
+		//! and returns it, nullptr if an equal tree was already stored.
+		const QPair<QVector<int>, QVector<Edge>> *addSteinerTree(const std::vector<std::pair<int, int>> &tree_edges,
+							const QVector<int> &tree_steiners, int cost,
+							QMap< QPair< QVector<int>, QVector<Edge> >, int > &dw_results,
+							QMap<Edge,QPair<QVector<Path>,QVector<QVector<int>>>> &super_edge_map,
+							QVector<int> &steiners,
+							QHash<int, BaseTable*> &tables_r);
 
 		//! \brief Multiply each super-edge possibilities between each other.
 		void cartesianProductOnSuperEdges(
 				QVector<QPair<
 					QVector<Path>,QVector<QVector<int>>>>& v,
 				QVector<int>& steiner_points,
-				QHash<Edge, QPair<BaseRelationship*, int>>& edges_hash,
+				QHash<Edge, int>& relationship_ids,
 				QHash<int, BaseTable*>& tables_r,
-				QMultiMap<int,
-					QPair<
-						QPair<QVector<BaseTable*>, QVector<BaseTable*>>,
-						QVector<QPair<BaseRelationship*, int>
-				>>>& super_res
+				GraphicalQueryBuilderPaths& super_res,
+				PathsIndex& super_res_index
 				);
 
 	public:
 		GraphicalQueryBuilderJoinSolver(GraphicalQueryBuilderPathWidget *widget,
-										QThread *thread, bool real_time_rendering, int delay);
+										GraphicalQueryBuilderSolverCache *cache,
+										GraphicalQueryBuilderProgress *progress,
+										GraphicalQueryBuilderHighlights *highlights,
+										bool real_time_rendering);
 
 		static constexpr unsigned
 		PT_SR=0,	//Steiner points
@@ -96,29 +491,50 @@ class GraphicalQueryBuilderJoinSolver: public QObject{
 		PT_FR1=3,	//Steiner points
 		PT_FR2=4;	//Involved tables non steiner
 
+		//! \brief Aliases for the Steiner tree engines, in st_engine_cmb order
+		static constexpr unsigned
+			Engine_Exact=0,			//k+1 trees, Dreyfus-Wagner
+			Engine_Mehlhorn=1,		//one tree, 2-approximation
+			Engine_ShortestPaths=2;	//one tree, 2-approximation
+
+		//! \brief Aliases for the custom cost rules' object and attribute,
+		//! in the custom_costs_tw combo boxes order
+		static constexpr unsigned
+			Rule_Rel=0,
+			Rule_Constraint=1,
+			Rule_Table=2,
+			Rule_Schema=3;
+		static constexpr unsigned
+			Rule_Name=0,
+			Rule_Comment=1;
+
 		//! \brief Aliases for the progress reports
 		static constexpr unsigned
 			Progress_ShortPathMod0=0,	//Two tables to join
-			Progress_SteinerRound=1,	//k+1-Steiner round
-			Progress_SteinerComb=2,		//k+1-Steiner combination
+			Progress_SteinerRound=1,	//k+1-Steiner pending sub-problems
+			Progress_SteinerComb=2,		//k+1-Steiner tree found
 			Progress_SuperEdgeRound=3,
 			Progress_ShortPathMod1=4,	// sub-paths found
 			Progress_FinalRound1=5,		//multiplication a
 			Progress_FinalRound2=6,		//multiplication b
 			Progress_FinalRound3=7,		//multiplication c
-			Progress_FinalRound4=8;		//multiplication d
+			Progress_FinalRound4=8,		//multiplication d
+			Progress_SteinerMemory=9,	//k+1-Steiner tables memory, or approximation
+			Progress_SteinerBound=10,	//Steiner tree cost and its bound, per mille
+			Progress_ResultsMemory=11,	//result containers memory, and pruning
+			Progress_ReportsCount=12;
 
 		//! \k+1 shortest paths.
 		//! This will compute all the possible paths between two points
-		//! for a given cost. Used a lot in findPath().
+		//! for a given cost, cheapest first, max_paths at most if not 0. Used a lot in findPath().
+		//! The paths do not cross the blocked tables : the other terminals, the dangling tables.
 		QPair<QVector<Path>, QVector<QVector<int>>> getDetailedPaths(Edge edge,
-										QVector<int> terminals,
+										const QBitArray &blocked_bits,
 										int cost,
-										CostMap &cost_map,
-										QHash<BaseTable*, int> &tables,
-										QHash<Edge, QPair<BaseRelationship*, int>> &edges_hash,
+										const CsrGraph &csr,
 										int mode,
-										QHash<int, BaseTable*> &tables_r);
+										QHash<int, BaseTable*> &tables_r,
+										int max_paths=0);
 
 
 	public slots:
@@ -129,21 +545,16 @@ class GraphicalQueryBuilderJoinSolver: public QObject{
 		//! it will be checked regularly during the solver run.
 		void handleJoinSolverStopRequest(void);
 
+		//! \brief Stops the run like handleJoinSolverStopRequest(), the paths
+		//! found until then being emitted as incomplete.
+		void handleJoinSolverDeadline(void);
+
 	private slots:
 
 	signals:
 
-		//! \brief Progress reports, sent at various steps of the solver run,
-		//! to the pathwidget status tab.
-		void s_progressUpdated(short mode,
-							   short st_round, short powN, long long st_comb, int st_found,
-							   int sp_current, int sp_current_on, long long sp_found,
-							   int st_fround, long long mult_entry, long long mult_entry_on, long long paths_found);
-
-		void s_progressTables(int mode, bts btss);
-
 		//! \brief Emitted when the solver is successful.
-		void s_pathsFound(paths paths_found);
+		void s_pathsFound(GraphicalQueryBuilderPaths paths_found);
 
 		//! \brief Emitted when the solver was canceled. It will allow thread->quit().
 		void s_solverStopped(void);
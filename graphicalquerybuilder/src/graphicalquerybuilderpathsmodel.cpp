@@ -0,0 +1,264 @@
+/*
+# PostgreSQL Database Modeler (pgModeler)
+#
+# Copyright 2006-2018 - Raphael Araújo e Silva <raphael@pgmodeler.io>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation version 3.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# The complete text of GPLv3 is at LICENSE file on source code root directory.
+# Also, you can get the complete GNU General Public License at <http://www.gnu.org/licenses/>
+*/
+
+#include "graphicalquerybuilderpathsmodel.h"
+#include <QApplication>
+#include <QPainter>
+
+GraphicalQueryBuilderPathsModel::GraphicalQueryBuilderPathsModel(QObject *parent) : QAbstractItemModel(parent)
+{
+	fetched_count=0;
+}
+
+void GraphicalQueryBuilderPathsModel::setPaths(const GraphicalQueryBuilderPaths &paths)
+{
+	beginResetModel();
+	this->paths=paths;
+	paths_by_cost=paths.getPathsByCost();
+	fetched_count=0;
+	relationships_cache.clear();
+	endResetModel();
+}
+
+void GraphicalQueryBuilderPathsModel::clear(void)
+{
+	setPaths(GraphicalQueryBuilderPaths());
+}
+
+int GraphicalQueryBuilderPathsModel::getPathRow(const QModelIndex &index)
+{
+	if(!index.isValid())
+		return -1;
+
+	//The relationships store the row of their path, plus one
+	return index.internalId()==0 ? index.row() : int(index.internalId())-1;
+}
+
+const QVector<QPair<BaseRelationship*, int>> &GraphicalQueryBuilderPathsModel::getRelationships(int row) const
+{
+	auto itr=relationships_cache.find(row);
+	if(itr==relationships_cache.end())
+		itr=relationships_cache.insert(row, paths.getRelationships(paths_by_cost[row]));
+	return itr.value();
+}
+
+QVector<BaseRelationship *> GraphicalQueryBuilderPathsModel::getPathRelationships(int row) const
+{
+	QVector<BaseRelationship *> rels;
+	if(row<0 || row>=paths_by_cost.size())
+		return rels;
+
+	for(const auto &rel:getRelationships(row))
+		rels.push_back(rel.first);
+	return rels;
+}
+
+int GraphicalQueryBuilderPathsModel::getRelationshipsCount(int row) const
+{
+	if(row<0 || row>=paths_by_cost.size())
+		return 0;
+	return GraphicalQueryBuilderPaths::countBits(paths.getBits(paths_by_cost[row]), paths.getWordsCount());
+}
+
+BaseRelationship *GraphicalQueryBuilderPathsModel::getRelationship(const QModelIndex &index) const
+{
+	if(!index.isValid() || index.internalId()==0)
+		return nullptr;
+	return getRelationships(getPathRow(index)).at(index.row()).first;
+}
+
+QModelIndex GraphicalQueryBuilderPathsModel::index(int row, int column, const QModelIndex &parent) const
+{
+	if(!hasIndex(row, column, parent))
+		return QModelIndex();
+
+	if(!parent.isValid())
+		return createIndex(row, column, quintptr(0));
+	return createIndex(row, column, quintptr(parent.row()+1));
+}
+
+QModelIndex GraphicalQueryBuilderPathsModel::parent(const QModelIndex &index) const
+{
+	if(!index.isValid() || index.internalId()==0)
+		return QModelIndex();
+	return createIndex(int(index.internalId())-1, PathColumn, quintptr(0));
+}
+
+int GraphicalQueryBuilderPathsModel::rowCount(const QModelIndex &parent) const
+{
+	if(!parent.isValid())
+		return fetched_count;
+
+	//Only the paths have children
+	if(parent.internalId()!=0 || parent.column()!=PathColumn)
+		return 0;
+	return getRelationshipsCount(parent.row());
+}
+
+int GraphicalQueryBuilderPathsModel::columnCount(const QModelIndex &) const
+{
+	return 3;
+}
+
+bool GraphicalQueryBuilderPathsModel::hasChildren(const QModelIndex &parent) const
+{
+	//A path has at least one relationship, no need to count them
+	if(!parent.isValid())
+		return fetched_count>0;
+	return parent.internalId()==0 && parent.column()==PathColumn;
+}
+
+QVariant GraphicalQueryBuilderPathsModel::data(const QModelIndex &index, int role) const
+{
+	if(!index.isValid())
+		return QVariant();
+
+	//A relationship : "rel_n weight"
+	if(index.internalId()!=0)
+	{
+		const auto &rel=getRelationships(getPathRow(index)).at(index.row());
+		if(role==Qt::DisplayRole && index.column()==PathColumn)
+			return rel.first->getName();
+		else if(role==Qt::DisplayRole && index.column()==CostColumn)
+			return rel.second;
+		else if(role==Qt::UserRole && index.column()==PathColumn)
+			return QVariant::fromValue<void *>(rel.first);
+		return QVariant();
+	}
+
+	//A path : "Path n", its total weight and its tables
+	int path=paths_by_cost[index.row()];
+	if(index.column()==PathColumn && role==Qt::DisplayRole)
+		return tr("Path %1").arg(index.row()+1);
+	else if(index.column()==CostColumn && role==Qt::DisplayRole)
+		return paths.getCost(path);
+	else if(index.column()==TablesColumn)
+	{
+		if(role==SteinersCountRole)
+			return paths.getSteiners(path).size();
+
+		if(role!=Qt::DisplayRole && role!=Qt::ToolTipRole && role!=TablesRole)
+			return QVariant();
+
+		QStringList labels;
+		for(const auto &tab:paths.getSteiners(path))
+			labels.push_back(tab->getName() + " - " + tab->getComment());
+		for(const auto &tab:paths.getTables(path))
+			labels.push_back(tab->getName() + " - " + tab->getComment());
+
+		if(role==TablesRole)
+			return labels;
+		return labels.join(role==Qt::ToolTipRole ? "\n" : ", ");
+	}
+	return QVariant();
+}
+
+QVariant GraphicalQueryBuilderPathsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if(orientation!=Qt::Horizontal)
+		return QVariant();
+
+	//A run stopped by its time limit : the best paths found until then
+	if(section==PathColumn && paths.isIncomplete())
+	{
+		if(role==Qt::DisplayRole)
+			return tr("Paths (incomplete)");
+		else if(role==Qt::ToolTipRole)
+			return tr("The time limit was reached : these are the best paths found until then.");
+	}
+
+	if(role!=Qt::DisplayRole)
+		return QVariant();
+
+	if(section==PathColumn)
+		return tr("Paths");
+	else if(section==CostColumn)
+		return tr("Cost");
+	return tr("Tables");
+}
+
+bool GraphicalQueryBuilderPathsModel::canFetchMore(const QModelIndex &parent) const
+{
+	return !parent.isValid() && fetched_count<paths_by_cost.size();
+}
+
+void GraphicalQueryBuilderPathsModel::fetchMore(const QModelIndex &parent)
+{
+	if(parent.isValid())
+		return;
+
+	int count=paths_by_cost.size()-fetched_count;
+	if(count<=0)
+		return;
+	if(count>FetchBatch)
+		count=FetchBatch;
+
+	beginInsertRows(QModelIndex(), fetched_count, fetched_count+count-1);
+	fetched_count+=count;
+	endInsertRows();
+}
+
+void GraphicalQueryBuilderTablesDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+	QStringList labels=index.data(GraphicalQueryBuilderPathsModel::TablesRole).toStringList();
+	if(labels.isEmpty())
+	{
+		QStyledItemDelegate::paint(painter, option, index);
+		return;
+	}
+
+	//The style draws the background and selection, the labels are drawn here
+	QStyleOptionViewItem opt=option;
+	initStyleOption(&opt, index);
+	opt.text.clear();
+	const QWidget *widget=option.widget;
+	QStyle *style=(widget ? widget->style() : QApplication::style());
+	style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
+
+	QRect rect=style->subElementRect(QStyle::SE_ItemViewItemText, &opt, widget);
+	int steiners_count=index.data(GraphicalQueryBuilderPathsModel::SteinersCountRole).toInt();
+	QFont steiner_font=opt.font;
+	steiner_font.setUnderline(true);
+
+	painter->save();
+	painter->setClipRect(rect);
+	painter->setPen(opt.palette.color((opt.state & QStyle::State_Selected) ?
+										  QPalette::HighlightedText : QPalette::Text));
+
+	int x=rect.left();
+	for(int i=0; i<labels.size() && x<rect.right(); i++)
+	{
+		QRect drawn;
+		QFont font=(i<steiners_count ? steiner_font : opt.font);
+		QString label=QFontMetrics(font).elidedText(labels[i], Qt::ElideRight, rect.right()-x);
+
+		painter->setFont(font);
+		painter->drawText(QRect(x, rect.top(), rect.right()-x, rect.height()),
+						  Qt::AlignLeft | Qt::AlignVCenter, label, &drawn);
+		x+=drawn.width();
+
+		if(i+1<labels.size())
+		{
+			painter->setFont(opt.font);
+			painter->drawText(QRect(x, rect.top(), qMax(rect.right()-x, 0), rect.height()),
+							  Qt::AlignLeft | Qt::AlignVCenter, ", ", &drawn);
+			x+=drawn.width();
+		}
+	}
+	painter->restore();
+}
@@ -0,0 +1,115 @@
+/*
+# PostgreSQL Database Modeler (pgModeler)
+#
+# Copyright 2006-2018 - Raphael Araújo e Silva <raphael@pgmodeler.io>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation version 3.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# The complete text of GPLv3 is at LICENSE file on source code root directory.
+# Also, you can get the complete GNU General Public License at <http://www.gnu.org/licenses/>
+*/
+
+/**
+\ingroup plugins/graphicalquerybuilder
+\class GraphicalQueryBuilderPathsModel
+\brief Item model of the automatic tab, over the paths found by the join solver.
+	The top level rows are the paths by cost, their children their relationships.
+	The view fetches the paths by batches as it scrolls, and a path's relationships
+	are only read from its bitset when the view asks for them.
+*/
+
+#ifndef GRAPHICALQUERYBUILDERPATHSMODEL_H
+#define GRAPHICALQUERYBUILDERPATHSMODEL_H
+
+#include "graphicalquerybuilderjoinsolver.h"
+#include <QAbstractItemModel>
+#include <QStyledItemDelegate>
+
+class GraphicalQueryBuilderPathsModel: public QAbstractItemModel {
+	private:
+		Q_OBJECT
+
+		//! \brief Number of paths added to the rows by each fetchMore()
+		static constexpr int FetchBatch=100;
+
+		GraphicalQueryBuilderPaths paths;
+
+		//! \brief Index in paths of each row, by cost
+		QVector<int> paths_by_cost;
+
+		//! \brief Number of rows fetched by the view
+		int fetched_count;
+
+		//! \brief Relationships of the paths the view asked the children of, by row
+		mutable QHash<int, QVector<QPair<BaseRelationship*, int>>> relationships_cache;
+
+		const QVector<QPair<BaseRelationship*, int>> &getRelationships(int row) const;
+
+	public:
+		static constexpr int PathColumn=0,
+		CostColumn=1,
+		TablesColumn=2;
+
+		//! \brief Data role of the tables column : the labels of the steiner points
+		//! then of the other non-terminal tables, as a QStringList
+		static constexpr int TablesRole=Qt::UserRole+1;
+
+		//! \brief Data role of the tables column : the number of steiner points
+		static constexpr int SteinersCountRole=Qt::UserRole+2;
+
+		GraphicalQueryBuilderPathsModel(QObject *parent=nullptr);
+
+		//! \brief Replaces the paths shown, no row being fetched yet
+		void setPaths(const GraphicalQueryBuilderPaths &paths);
+
+		void clear(void);
+
+		//! \brief Number of paths, fetched or not
+		int getPathsCount(void) const { return paths_by_cost.size(); }
+
+		//! \brief Row of the path of an index, itself or one of its relationships, -1 if invalid
+		static int getPathRow(const QModelIndex &index);
+
+		//! \brief Relationships of the path at a row, fetched or not
+		QVector<BaseRelationship *> getPathRelationships(int row) const;
+
+		int getRelationshipsCount(int row) const;
+
+		//! \brief Relationship of a child index, nullptr for a path index
+		BaseRelationship *getRelationship(const QModelIndex &index) const;
+
+		QModelIndex index(int row, int column, const QModelIndex &parent=QModelIndex()) const override;
+		QModelIndex parent(const QModelIndex &index) const override;
+		int rowCount(const QModelIndex &parent=QModelIndex()) const override;
+		int columnCount(const QModelIndex &parent=QModelIndex()) const override;
+		bool hasChildren(const QModelIndex &parent=QModelIndex()) const override;
+		QVariant data(const QModelIndex &index, int role=Qt::DisplayRole) const override;
+		QVariant headerData(int section, Qt::Orientation orientation, int role=Qt::DisplayRole) const override;
+		bool canFetchMore(const QModelIndex &parent) const override;
+		void fetchMore(const QModelIndex &parent) override;
+};
+
+/**
+\ingroup plugins/graphicalquerybuilder
+\class GraphicalQueryBuilderTablesDelegate
+\brief Paints the tables of a path on a single line, the steiner points
+	(the non-terminals that are "central points") underlined.
+*/
+class GraphicalQueryBuilderTablesDelegate: public QStyledItemDelegate {
+	private:
+		Q_OBJECT
+
+	public:
+		GraphicalQueryBuilderTablesDelegate(QObject *parent=nullptr) : QStyledItemDelegate(parent) {}
+
+		void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+};
+
+#endif // GRAPHICALQUERYBUILDERPATHSMODEL_H
@@ -18,6 +18,7 @@
 
 #include "graphicalquerybuilderpathwidget.h"
 #include "graphicalquerybuildercorewidget.h"
+#include <QtMath>
 
 GraphicalQueryBuilderPathWidget::GraphicalQueryBuilderPathWidget(QWidget *parent) : QWidget(parent)
 {
@@ -59,6 +60,7 @@ GraphicalQueryBuilderPathWidget::GraphicalQueryBuilderPathWidget(QWidget *parent
 
 
 #ifdef GRAPHICAL_QUERY_BUILDER_JOIN_SOLVER
+	join_solver=nullptr;
 	join_solver_thread=nullptr;
 	man_tb->setVisible(true);
 	auto_tb->setVisible(true);
@@ -122,13 +124,14 @@ GraphicalQueryBuilderPathWidget::GraphicalQueryBuilderPathWidget(QWidget *parent
 			gqb_c->updateRelLabel();
 		}
 
-		else if(path_sw->currentIndex()==Automatic && auto_path_tw->currentRow()!=-1)
+		else if(path_sw->currentIndex()==Automatic && auto_path_tv->currentIndex().isValid())
 		{
-			path_mode_set=qMakePair<int,int>(Automatic, auto_path_tw->currentRow());
+			path_mode_set=qMakePair<int,int>(Automatic,
+				GraphicalQueryBuilderPathsModel::getPathRow(auto_path_tv->currentIndex()));
 			gqb_c->updateRelLabel();
 		}
-		else if(path_sw->currentIndex()==Automatic && auto_path_tw->currentRow()==-1 &&
-					auto_path_tw->rowCount()>0)
+		else if(path_sw->currentIndex()==Automatic && !auto_path_tv->currentIndex().isValid() &&
+					auto_paths_model->getPathsCount()>0)
 		{
 			path_mode_set=qMakePair<int,int>(Automatic, 0);
 			gqb_c->updateRelLabel();
@@ -152,6 +155,16 @@ GraphicalQueryBuilderPathWidget::GraphicalQueryBuilderPathWidget(QWidget *parent
 		st_limit_sb->setEnabled(!clicked);
 	});
 
+	connect(st_engine_cmb, QOverload<int>::of(&QComboBox::currentIndexChanged), [&](int index){
+		bool exact=(index==GraphicalQueryBuilderJoinSolver::Engine_Exact);
+		dw_iterative_cb->setEnabled(exact);
+		dw_threads_sb->setEnabled(exact);
+		dw_mem_budget_sb->setEnabled(exact);
+	});
+
+	dw_threads_sb->setMaximum(qMax(QThread::idealThreadCount(), 64));
+	dw_threads_sb->setValue(qMax(QThread::idealThreadCount(), 1));
+
 	reset_menu.addAction(tr("All"), this, SLOT(resetPaths()));
 	reset_menu.addAction(tr("Manual"), this, SLOT(resetPaths()));
 	reset_menu.addAction(tr("Automatic"), this, SLOT(resetPaths()));
@@ -175,7 +188,51 @@ GraphicalQueryBuilderPathWidget::GraphicalQueryBuilderPathWidget(QWidget *parent
 		custom_costs_tw->setRowCount(0);
 	});
 
-	connect(auto_path_tw, SIGNAL(currentCellChanged(int, int, int, int)), this, SLOT(automaticPathSelected(int, int, int, int)));
+	progress_timer.setInterval(progress_poll_interval);
+	connect(&progress_timer, SIGNAL(timeout()), this, SLOT(pollProgress()));
+
+	deadline_timer.setSingleShot(true);
+
+	highlights.reset(new GraphicalQueryBuilderHighlights(highlights_capacity));
+	connect(&highlight_timer, SIGNAL(timeout()), this, SLOT(drawHighlight()));
+
+	auto_paths_model=new GraphicalQueryBuilderPathsModel(this);
+	auto_path_tv->setModel(auto_paths_model);
+	auto_path_tv->setItemDelegateForColumn(GraphicalQueryBuilderPathsModel::TablesColumn,
+										   new GraphicalQueryBuilderTablesDelegate(auto_path_tv));
+
+	//Highlight the given path relations if shift modifier pressed.
+	connect(auto_path_tv, &QTreeView::clicked, [&](const QModelIndex &index){
+		auto k_modifiers = QGuiApplication::queryKeyboardModifiers();
+		if(!(k_modifiers & Qt::ShiftModifier))
+			return;
+
+		QVector<BaseRelationship *> rels;
+		auto rel=auto_paths_model->getRelationship(index);
+		if(rel)
+			rels.push_back(rel);
+		else
+		{
+			model_wgt->getObjectsScene()->clearSelection();
+			rels=auto_paths_model->getPathRelationships(GraphicalQueryBuilderPathsModel::getPathRow(index));
+		}
+
+		QList<BaseObjectView *> obj;
+		for(const auto &base_rel:rels)
+			obj.push_back(dynamic_cast<BaseObjectView *>(base_rel->getOverlyingObject()));
+		for (const auto &ob:obj)
+			ob->setSelected(true);
+		emit s_adjustViewportToItems(obj);
+	});
+#endif
+}
+
+GraphicalQueryBuilderPathWidget::~GraphicalQueryBuilderPathWidget(void)
+{
+#ifdef GRAPHICAL_QUERY_BUILDER_JOIN_SOLVER
+	//A running solver still reads its cache
+	joinThread();
+	qDeleteAll(solver_caches);
 #endif
 }
 
@@ -243,114 +300,27 @@ QMap<int, BaseRelationship *> GraphicalQueryBuilderPathWidget::getRelPath(void)
 			rel_path_res.insert(i, base_rel);
 		}
 	}
+#ifdef GRAPHICAL_QUERY_BUILDER_JOIN_SOLVER
 	else
 	{
-		auto path_twi=dynamic_cast<QTreeWidget *>(
-			auto_path_tw->cellWidget(path_mode_set.second,0))->topLevelItem(0);
-		for(int i=0;i<path_twi->childCount();i++)
-		{
-			auto base_rel = reinterpret_cast<BaseRelationship *>(path_twi->child(i)->data(0,Qt::UserRole).value<void *>());
-			rel_path_res.insert(i, base_rel);
-		}
+		auto rels=auto_paths_model->getPathRelationships(path_mode_set.second);
+		for(int i=0;i<rels.size();i++)
+			rel_path_res.insert(i, rels[i]);
 	}
+#endif
 	return rel_path_res;
 }
 
 
 #ifdef GRAPHICAL_QUERY_BUILDER_JOIN_SOLVER
-void GraphicalQueryBuilderPathWidget::insertAutoRels(paths paths_found)
+void GraphicalQueryBuilderPathWidget::insertAutoRels(GraphicalQueryBuilderPaths paths_found)
 {
-	this->resetAutoPath();
-
-	int i=-1;
-	for(auto it=paths_found.begin(); it!=paths_found.end();it++)
-	{
-		i+=1;
-		auto_path_tw->insertRow(auto_path_tw->rowCount());
-
-		//Insert path header : "Path n"
-		auto tw= new QTreeWidget;
-		tw->setColumnCount(2);
-		tw->setHeaderLabels({"Path " + QString::number(i+1),"Cost"});
-		auto tw_top_item=new QTreeWidgetItem;
-		tw_top_item->setText(0,"Path " + QString::number(i+1));
-		tw->addTopLevelItem(tw_top_item);
-		auto_path_tw->setCellWidget(auto_path_tw->rowCount()-1,0,tw);
-
-		//Highlight the given path relations if shift modifier pressed.
-		connect(tw, &QTreeWidget::itemClicked, [&, tw](QTreeWidgetItem *item, [[maybe_unused]]int column){
-
-			auto k_modifiers = QGuiApplication::queryKeyboardModifiers();
-			if(k_modifiers & Qt::ShiftModifier)
-			{
-				QList<BaseObjectView *> obj;
-				if(item==tw->topLevelItem(0))
-				{
-					model_wgt->getObjectsScene()->clearSelection();
-					for(int i=0;i<item->childCount();i++)
-					{
-						obj.push_back(
-							dynamic_cast<BaseObjectView *>(
-								reinterpret_cast<BaseRelationship *>(
-									item->child(i)->data(0, Qt::UserRole).value<void *>())
-										->getOverlyingObject()));
-					}
-				}
-				else
-				{
-					obj.push_back(
-						dynamic_cast<BaseObjectView *>(
-							reinterpret_cast<BaseRelationship *>(
-								item->data(0, Qt::UserRole).value<void *>())
-									->getOverlyingObject()));
-				}
-
-				for (const auto &ob:obj)
-					ob->setSelected(true);
-				emit s_adjustViewportToItems(obj);
-			}
-		});
-
-		//For this path insert the relations with their weight : "rel_n weight"
-		for (const auto &qrel : it.value().second)
-		{
-			auto tw_item=new QTreeWidgetItem;
-			tw_item->setText(0, qrel.first->getName());
-			tw_item->setText(1, QString::number(qrel.second));
-			tw_item->setData(0,Qt::UserRole, QVariant::fromValue<void *>(qrel.first));
-			tw_top_item->addChild(tw_item);
-		}
-		//Set the total weight of the current path
-		tw_top_item->setText(1,QString::number(it.key()));
-
-		tw_top_item->setExpanded(true);
-		tw->resizeColumnToContents(0);
-
-		//Set the second column headers
-		auto tw2= new QTreeWidget;
-		tw2->setColumnCount(1);
-		tw2->setHeaderLabels({"Tables"});
-		auto_path_tw->setCellWidget(auto_path_tw->rowCount()-1,1,tw2);
-		//Insert steiner points (non-terminals that are "central points") with underlined text.
-		for (const auto &tab : it.value().first.first)
-		{
-			auto twi=new QTreeWidgetItem;
-			twi->setText(0, tab->getName() + " - " + tab->getComment());
-			auto the_font=twi->font(0);
-			the_font.setUnderline(true);
-			twi->setFont(0,the_font);
-			tw2->addTopLevelItem(twi);
-		}
-		//Insert non-terminals non-steiner.
-		for (const auto &tab : it.value().first.second)
-		{
-			auto twi=new QTreeWidgetItem;
-			twi->setText(0, tab->getName() + " - " + tab->getComment());
-			tw2->addTopLevelItem(twi);
-		}
-	}
-	auto_path_tw->resizeRowsToContents();
-	auto_path_tw->horizontalHeader()->setVisible(true);
+	//The view fetches the rows it shows, and the relationships of the paths it expands
+	auto_paths_model->setPaths(paths_found);
+	if(auto_paths_model->canFetchMore(QModelIndex()))
+		auto_paths_model->fetchMore(QModelIndex());
+	auto_path_tv->expand(auto_paths_model->index(0, GraphicalQueryBuilderPathsModel::PathColumn));
+	auto_path_tv->resizeColumnToContents(GraphicalQueryBuilderPathsModel::PathColumn);
 	path_sw->setCurrentIndex(1);
 }
 #endif
@@ -364,7 +334,9 @@ void GraphicalQueryBuilderPathWidget::resetPaths(void)
 		path_sw->setCurrentIndex(0);
 		path_mode_set=qMakePair<int,int>(Manual,0);
 
-		auto_path_tw->setRowCount(0);
+#ifdef GRAPHICAL_QUERY_BUILDER_JOIN_SOLVER
+		resetAutoPath();
+#endif
 
 		gqb_c->updateRelLabel();
 
@@ -372,9 +344,16 @@ void GraphicalQueryBuilderPathWidget::resetPaths(void)
 		sp_max_cost_sb->setEnabled(false);
 		st_limit_sb->setEnabled(false);
 		sp_max_cost_sb->setValue(2);
+		paths_limit_sb->setValue(1000);
+		deadline_sb->setValue(0);
+		res_mem_budget_sb->setValue(2048);
 		st_limit_sb->setValue(5);
 
 		vis_only_cb->setChecked(false);
+		dw_iterative_cb->setChecked(true);
+		dw_threads_sb->setValue(qMax(QThread::idealThreadCount(), 1));
+		dw_mem_budget_sb->setValue(1024);
+		st_engine_cmb->setCurrentIndex(GraphicalQueryBuilderJoinSolver::Engine_Exact);
 		default_cost_sb->setValue(1);
 		cross_sch_cost_sb->setValue(3);
 
@@ -391,7 +370,7 @@ void GraphicalQueryBuilderPathWidget::resetPaths(void)
 	}
 	else if(qobject_cast<QAction *>(sender()) == reset_menu.actions().at(2))
 	{
-		auto_path_tw->setRowCount(0);
+		resetAutoPath();
 		path_sw->setCurrentIndex(1);
 		path_mode_set=qMakePair<int,int>(Automatic,0);
 		gqb_c->updateRelLabel();
@@ -402,9 +381,16 @@ void GraphicalQueryBuilderPathWidget::resetPaths(void)
 		sp_max_cost_sb->setEnabled(false);
 		st_limit_sb->setEnabled(false);
 		sp_max_cost_sb->setValue(2);
+		paths_limit_sb->setValue(1000);
+		deadline_sb->setValue(0);
+		res_mem_budget_sb->setValue(2048);
 		st_limit_sb->setValue(5);
 
 		vis_only_cb->setChecked(false);
+		dw_iterative_cb->setChecked(true);
+		dw_threads_sb->setValue(qMax(QThread::idealThreadCount(), 1));
+		dw_mem_budget_sb->setValue(1024);
+		st_engine_cmb->setCurrentIndex(GraphicalQueryBuilderJoinSolver::Engine_Exact);
 		default_cost_sb->setValue(1);
 		cross_sch_cost_sb->setValue(3);
 
@@ -421,18 +407,50 @@ void GraphicalQueryBuilderPathWidget::resetPaths(void)
 }
 
 #ifdef GRAPHICAL_QUERY_BUILDER_JOIN_SOLVER
-void GraphicalQueryBuilderPathWidget::automaticPathSelected(int new_row, int new_column, int old_row, int old_column)
+GraphicalQueryBuilderSolverCache *GraphicalQueryBuilderPathWidget::getSolverCache(void)
 {
-	auto dummy=new_row+new_column+old_column;
-	dummy++;
+	if(solver_caches.contains(model_wgt))
+		return solver_caches.value(model_wgt);
+
+	auto cache=new GraphicalQueryBuilderSolverCache;
+	solver_caches.insert(model_wgt, cache);
+
+	//Added or removed relationships and tables, or any edit (names and comments
+	//weigh through the custom costs) : the next run compares the model with the cache.
+	QList<QMetaObject::Connection> &connections=solver_cache_connections[model_wgt];
+	connections.push_back(connect(model_wgt->getDatabaseModel(), &DatabaseModel::s_objectAdded, this, [cache](BaseObject *object){
+		if(dynamic_cast<BaseRelationship *>(object) || dynamic_cast<BaseTable *>(object))
+			cache->model_changed=true;
+	}));
+	connections.push_back(connect(model_wgt->getDatabaseModel(), &DatabaseModel::s_objectRemoved, this, [cache](BaseObject *object){
+		if(dynamic_cast<BaseRelationship *>(object) || dynamic_cast<BaseTable *>(object))
+			cache->model_changed=true;
+	}));
+	connections.push_back(connect(model_wgt, &ModelWidget::s_objectModified, this, [cache](){
+		cache->model_changed=true;
+	}));
+
+	ModelWidget *model=model_wgt;
+	connections.push_back(connect(model_wgt, &QObject::destroyed, this, [this, model](){
+		dropSolverCache(model);
+	}));
+
+	return cache;
+}
 
-	if(old_row!=-1 && new_row!=-1)
-		{
-			auto old_tw1= dynamic_cast<QTreeWidget *>(auto_path_tw->cellWidget(old_row, 0));
-			old_tw1->setCurrentItem(nullptr);
-			auto old_tw2= dynamic_cast<QTreeWidget *>(auto_path_tw->cellWidget(old_row, 1));
-			old_tw2->setCurrentItem(nullptr);
-		}
+void GraphicalQueryBuilderPathWidget::dropSolverCache(ModelWidget *model)
+{
+	for(const auto &connection:solver_cache_connections.take(model))
+		disconnect(connection);
+
+	//A run on the closed model still reads its cache : it ends before the cache
+	GraphicalQueryBuilderSolverCache *cache=solver_caches.take(model);
+	if(join_solver_thread && join_solver->cache==cache)
+	{
+		joinThread();
+		stop_solver_pb->setEnabled(false);
+	}
+	delete cache;
 }
 
 void GraphicalQueryBuilderPathWidget::createThread(void)
@@ -441,7 +459,8 @@ void GraphicalQueryBuilderPathWidget::createThread(void)
 	{
 		join_solver_thread=new QThread(this);
 		join_solver=new GraphicalQueryBuilderJoinSolver(
-					this, join_solver_thread, real_time_rendering_cb->isChecked(), rt_render_delay_sb->value());
+					this, getSolverCache(), &join_solver_progress, highlights.get(),
+					real_time_rendering_cb->isChecked());
 		join_solver->moveToThread(join_solver_thread);
 
 		connect(join_solver_thread, &QThread::started, [&](){
@@ -452,43 +471,32 @@ void GraphicalQueryBuilderPathWidget::createThread(void)
 
 		connect(this, SIGNAL(s_stopJoinSolverRequested()), join_solver, SLOT(handleJoinSolverStopRequest()),
 				Qt::DirectConnection);
+		connect(&deadline_timer, SIGNAL(timeout()), join_solver, SLOT(handleJoinSolverDeadline()),
+				Qt::DirectConnection);
 
 		connect(join_solver_thread, &QThread::finished, [&](){
 			join_solver_thread=nullptr;
 		});
 
-		qRegisterMetaType<paths>();
+		qRegisterMetaType<GraphicalQueryBuilderPaths>();
 		connect(join_solver,
-				SIGNAL(s_pathsFound(paths)),
+				SIGNAL(s_pathsFound(GraphicalQueryBuilderPaths)),
 				this,
-				SLOT(handlePathsFound(paths)),
-				Qt::QueuedConnection);
-
-		//TODO those queued messages are handled poorly in VMs. Would need bottlenecking-checks.
-		connect(join_solver,
-				SIGNAL(s_progressUpdated(short,
-										 short,short,long long,int,
-										 int,int,long long,
-										 int,long long,long long,long long)),
-				this,
-				SLOT(updateProgress(short,
-									short,short,long long,int,
-									int,int,long long,
-									int,long long,long long,long long)),
+				SLOT(handlePathsFound(GraphicalQueryBuilderPaths)),
 				Qt::QueuedConnection);
 
 		connect(join_solver, SIGNAL(s_solverStopped()), this, SLOT(stopSolver()), Qt::QueuedConnection);
 
-		qRegisterMetaType<bts>();
-		connect(join_solver, SIGNAL(s_progressTables(int, bts)),
-				this, SLOT(progressTables(int, bts)), Qt::QueuedConnection);
 		connect(join_solver_thread, &QThread::finished, [&](){progressTables(10,{nullptr});});
 	}
 }
 
-void GraphicalQueryBuilderPathWidget::handlePathsFound(paths p)
+void GraphicalQueryBuilderPathWidget::handlePathsFound(GraphicalQueryBuilderPaths p)
 {
-	if(III_prb->isEnabled())
+	pollProgress();
+	if(p.isIncomplete())
+		paths_found_lbl->setText(tr("%1 (time limit reached, incomplete)").arg(p.size()));
+	else if(III_prb->isEnabled())
 		III_prb->setValue(100);
 	insertAutoRels(p);
 	destroyThread(true);
@@ -501,53 +509,76 @@ void GraphicalQueryBuilderPathWidget::destroyThread(bool force)
 {
 	if(join_solver_thread && force)
 	{
+		progress_timer.stop();
+		highlight_timer.stop();
+		deadline_timer.stop();
+		//The highlights still queued are discarded, not drawn : they show a search
+		//the run is done with, and the finished thread removes the drawn ones anyway.
+		highlights->consume_all([](const GraphicalQueryBuilderHighlight &){});
 		disconnect(join_solver_thread, &QThread::started, nullptr, nullptr);
 		disconnect(this, SIGNAL(s_stopJoinSolverRequested()), nullptr, nullptr);
+		disconnect(&deadline_timer, SIGNAL(timeout()), nullptr, nullptr);
 		disconnect(stop_solver_pb, &QPushButton::toggled, nullptr, nullptr);
-		disconnect(join_solver, SIGNAL(s_pathsFound(paths)), nullptr, nullptr);
-		disconnect(join_solver,
-				SIGNAL(s_progressUpdated(short,
-										 short,short,long long,int,
-										 int,int,long long,
-										 int,long long,long long,long long)),
-				nullptr, nullptr);
+		disconnect(join_solver, SIGNAL(s_pathsFound(GraphicalQueryBuilderPaths)), nullptr, nullptr);
 		disconnect(join_solver, SIGNAL(s_solverStopped()), nullptr, nullptr);
 
 		delete(join_solver);
+		join_solver=nullptr;
 		join_solver_thread->quit();
 	}
 }
 
+void GraphicalQueryBuilderPathWidget::joinThread(void)
+{
+	if(!join_solver_thread)
+		return;
+
+	//The thread forgets itself once finished, so the solver is deleted here
+	QThread *thread=join_solver_thread;
+	emit s_stopJoinSolverRequested();
+	thread->quit();
+	thread->wait();
+
+	progress_timer.stop();
+	highlight_timer.stop();
+	deadline_timer.stop();
+	highlights->consume_all([](const GraphicalQueryBuilderHighlight &){});
+	delete(join_solver);
+	join_solver=nullptr;
+}
+
 void GraphicalQueryBuilderPathWidget::runSQLJoinSolver(void)
 {
 	createThread();
 	resetJoinSolverStatus();
 	stop_solver_pb->setEnabled(true);
+	join_solver_progress.reset();
+	progress_timer.start();
+	if(real_time_rendering_cb->isChecked())
+		highlight_timer.start(qMax(rt_render_delay_sb->value(), highlight_min_interval));
+	if(deadline_sb->value()>0)
+		deadline_timer.start(deadline_sb->value());
 	join_solver_thread->start();
 }
 
-void GraphicalQueryBuilderPathWidget::updateProgress(
-		short mode,
-		short st_round, short powN, long long st_comb, int st_found,
-		int sp_current, int sp_current_on, long long sp_found,
-		int st_fround, long long mult_entry, long long mult_entry_on, long long paths_found)
+void GraphicalQueryBuilderPathWidget::pollProgress(void)
 {
-	if(!join_solver_thread || !join_solver_thread->isRunning() || join_solver->stop_solver_requested)
-		return;
+	unsigned updated=join_solver_progress.takeUpdated();
+	for(unsigned mode=0; mode<GraphicalQueryBuilderJoinSolver::Progress_ReportsCount; mode++)
+		if(updated & (1u<<mode))
+			updateProgress(mode);
+}
 
-	QLocale big_nb_locale;
-	big_nb_locale.setDefault(QLocale(QLocale::English, QLocale::UnitedStates));
+void GraphicalQueryBuilderPathWidget::updateProgress(unsigned mode)
+{
+	//The last reports of a run stopped by its time limit are still shown
+	if(!join_solver_thread || !join_solver_thread->isRunning() ||
+			(join_solver->stop_solver_requested && !join_solver->deadline_reached))
+		return;
 
-	//static constexpr unsigned
-	//	Progress_ShortPathMod0=0,
-	//	Progress_SteinerRound=1,
-	//	Progress_SteinerComb=2,
-	//	Progress_SuperEdgeRound=3,
-	//	Progress_ShortPathMod1=4,
-	//	Progress_FinalRound1=5,
-	//	Progress_FinalRound2=6,
-	//	Progress_FinalRound3=7,
-	//	Progress_FinalRound4=8;
+	static const QLocale big_nb_locale(QLocale::English, QLocale::UnitedStates);
+	auto value=[this](unsigned counter){ return join_solver_progress.get(counter); };
+	using Progress=GraphicalQueryBuilderProgress;
 
 	switch(mode)
 	{
@@ -558,70 +589,101 @@ void GraphicalQueryBuilderPathWidget::updateProgress(
 		st_comb_on_lbl->setEnabled(false);
 		st_found_lbl->setEnabled(false);
 		st_found_on_lbl->setEnabled(false);
+		st_mem_lbl->setEnabled(false);
+		st_bound_lbl->setEnabled(false);
 		I_prb->setEnabled(false);
 		sp_current_lbl->setText("1");
 		sp_current_on_lbl->setText("1");
 		II_prb->setEnabled(false);
 		sp_found_lbl->setText(
-					big_nb_locale.toString(sp_found));
+					big_nb_locale.toString(value(Progress::SpFound)));
 		st_fround_lbl->setEnabled(false);
 		st_fround_on_lbl->setEnabled(false);
 		III_prb->setEnabled(false);
 		paths_found_lbl->setText(
-					big_nb_locale.toString(paths_found));
+					big_nb_locale.toString(value(Progress::PathsFound)));
 		break;
 
-	case GraphicalQueryBuilderJoinSolver::Progress_SteinerRound: //k+1-Steiner round
-		st_round_lbl->setText(QString::number(st_round));
-		powN_lbl->setText(QString::number(powN));
-		st_comb_lbl->setText(
-					big_nb_locale.toString(st_comb));
-		st_comb_on_lbl->setText(
-					big_nb_locale.toString((long long) pow(2,powN)) +
-					" (2^" + QString::number(powN) +")");
+	case GraphicalQueryBuilderJoinSolver::Progress_SteinerRound: //k+1-Steiner pending sub-problems
+		st_round_lbl->setText(
+					big_nb_locale.toString(value(Progress::StRound)));
+		powN_lbl->setText(QString::number(value(Progress::PowN)));
 		if(st_found_on_lbl->text()=="/") st_found_on_lbl->setText("/ "+QString::number(st_limit_sb->value()));
 		break;
 
-	case GraphicalQueryBuilderJoinSolver::Progress_SteinerComb: //k+1-Steiner combination
-		st_comb_lbl->setText(QString::number(st_comb));
-		st_found_lbl->setText(QString::number(st_found));
-		I_prb->setValue(st_found*100/st_limit_sb->value());
+	case GraphicalQueryBuilderJoinSolver::Progress_SteinerComb: //k+1-Steiner tree found
+		st_comb_lbl->setText(
+					big_nb_locale.toString(value(Progress::StComb)));
+		st_found_lbl->setText(QString::number(value(Progress::StFound)));
+		I_prb->setValue(value(Progress::StFound)*100/st_limit_sb->value());
 		break;
 
 	case GraphicalQueryBuilderJoinSolver::Progress_SuperEdgeRound: //super_edge round
+	{
 		I_prb->setValue(100);
+		long long sp_current=value(Progress::SpCurrent), sp_current_on=value(Progress::SpCurrentOn);
 		sp_current_lbl->setText(QString::number(sp_current));
 		sp_current_on_lbl->setText("/ "+QString::number(sp_current_on));
 		II_prb->setValue(
 					(sp_current<1?0:sp_current-1)*100/sp_current_on);
 		break;
+	}
 
 	case GraphicalQueryBuilderJoinSolver::Progress_ShortPathMod1: // sub-paths found
 		sp_found_lbl->setText(
-					big_nb_locale.toString((long long)sp_found));
+					big_nb_locale.toString(value(Progress::SpFound)));
 		break;
 
 	case GraphicalQueryBuilderJoinSolver::Progress_FinalRound1: //multiplication a
+	{
 		II_prb->setValue(100);
+		long long st_fround=value(Progress::StFRound);
 		st_fround_lbl->setText(QString::number(st_fround));
 		if(st_fround_on_lbl->text()=="/") st_fround_on_lbl->setText("/ "+st_found_lbl->text());
 		III_prb->setValue(
-					(st_fround<1?0:st_fround-1)*100/st_found_lbl->text().toInt());
+					(st_fround<1?0:st_fround-1)*100/qMax(st_found_lbl->text().toInt(), 1));
 		break;
+	}
 
 	case GraphicalQueryBuilderJoinSolver::Progress_FinalRound2: // multiplication b
 		mult_entry_on_lbl->setText(
-					big_nb_locale.toString((long long)mult_entry_on));
+					big_nb_locale.toString(value(Progress::MultEntryOn)));
 		break;
 
 	case GraphicalQueryBuilderJoinSolver::Progress_FinalRound3: // multiplication c
 		mult_entry_lbl->setText(
-					big_nb_locale.toString((long long)mult_entry));
+					big_nb_locale.toString(value(Progress::MultEntry)));
 		break;
 
 	case GraphicalQueryBuilderJoinSolver::Progress_FinalRound4: //multiplication d
 		paths_found_lbl->setText(
-					big_nb_locale.toString((long long)paths_found));
+					big_nb_locale.toString(value(Progress::PathsFound)));
+		break;
+
+	case GraphicalQueryBuilderJoinSolver::Progress_SteinerMemory: //k+1-Steiner tables memory, or approximation
+		st_mem_lbl->setText(
+					big_nb_locale.toString((value(Progress::StMemory)+1023)/1024)+" KiB"+
+					(value(Progress::StApproximated)? tr(" > budget : approximated tree") : ""));
+		break;
+
+	case GraphicalQueryBuilderJoinSolver::Progress_SteinerBound: //Steiner tree cost and its bound, per mille
+	{
+		long long st_cost=value(Progress::StCost), st_ratio=value(Progress::StRatio);
+		if(st_ratio<=1000)
+			st_bound_lbl->setText(tr("cost %1, optimal").arg(st_cost));
+		else
+			st_bound_lbl->setText(tr("cost %1, at most %2 x optimal (optimal >= %3)")
+								  .arg(st_cost)
+								  .arg(st_ratio/1000.0, 0, 'f', 3)
+								  .arg(qCeil(st_cost*1000.0/st_ratio)));
+		break;
+	}
+
+	case GraphicalQueryBuilderJoinSolver::Progress_ResultsMemory: //result containers memory, and pruning
+		res_mem_lbl->setText(
+					big_nb_locale.toString((value(Progress::ResMemory)+1023)/1024)+" KiB"+
+					(value(Progress::ResPruned)? tr(" > budget : cheapest kept") : ""));
+		break;
 	}
 }
 
@@ -636,7 +698,7 @@ void GraphicalQueryBuilderPathWidget::resetJoinSolverStatus(void){
 	st_comb_lbl->setText("");
 
 	st_comb_on_lbl->setEnabled(true);
-	st_comb_on_lbl->setText("/");
+	st_comb_on_lbl->setText("");
 
 	st_found_lbl->setEnabled(true);
 	st_found_lbl->setText("");
@@ -644,6 +706,14 @@ void GraphicalQueryBuilderPathWidget::resetJoinSolverStatus(void){
 	st_found_on_lbl->setEnabled(true);
 	st_found_on_lbl->setText("/");
 
+	st_mem_lbl->setEnabled(true);
+	st_mem_lbl->setText("");
+
+	st_bound_lbl->setEnabled(true);
+	st_bound_lbl->setText("");
+
+	res_mem_lbl->setText("");
+
 	I_prb->setEnabled(true);
 	I_prb->setValue(0);
 
@@ -678,6 +748,13 @@ void GraphicalQueryBuilderPathWidget::stopSolver(){
 	stop_solver_pb->setEnabled(false);
 }
 
+void GraphicalQueryBuilderPathWidget::drawHighlight(void)
+{
+	GraphicalQueryBuilderHighlight highlight;
+	if(highlights->pop(highlight))
+		progressTables(highlight.mode, highlight.tables);
+}
+
 void GraphicalQueryBuilderPathWidget::progressTables(int mode, bts t)
 {
 	for(auto &pix:pixs)
@@ -35,15 +35,10 @@
 
 #ifdef GRAPHICAL_QUERY_BUILDER_JOIN_SOLVER
 #include "graphicalquerybuilderjoinsolver.h"
+#include "graphicalquerybuilderpathsmodel.h"
 #include <QMetaType>
-typedef QMultiMap<int,
-QPair<
-	  QPair<QVector<BaseTable*>, QVector<BaseTable*>>,
-	  QVector<QPair<BaseRelationship*, int>
->>> paths;
-Q_DECLARE_METATYPE(paths);
-typedef QVector<BaseTable *> bts;
-Q_DECLARE_METATYPE(bts);
+#include <QTimer>
+Q_DECLARE_METATYPE(GraphicalQueryBuilderPaths);
 #endif
 
 class GraphicalQueryBuilderCoreWidget;
@@ -69,6 +64,44 @@ private:
 		QThread *join_solver_thread;
 
 		QVector<QGraphicsItem *> pixs, tr_pixs;
+
+		//! \brief Model of the automatic tab, over the paths found
+		GraphicalQueryBuilderPathsModel *auto_paths_model;
+
+		//! \brief Progress counters of the solver run, and the timer polling them
+		GraphicalQueryBuilderProgress join_solver_progress;
+		QTimer progress_timer;
+
+		//! \brief Stops the solver run once the time limit is past, the paths found
+		//! until then being shown as incomplete
+		QTimer deadline_timer;
+
+		//! \brief Status tab refresh rate, about 20 per second
+		static constexpr int progress_poll_interval=50;
+
+		//! \brief Real-time rendering highlights of the solver run, and the timer
+		//! drawing them one per rendering delay. The ones left when the run ends
+		//! are discarded.
+		std::unique_ptr<GraphicalQueryBuilderHighlights> highlights;
+		QTimer highlight_timer;
+
+		//! \brief Highlights waiting at most : past them, the solver drops its highlights
+		static constexpr int highlights_capacity=64;
+
+		//! \brief Shortest time a highlight is shown, 25 per second
+		static constexpr int highlight_min_interval=40;
+
+		//! \brief Solver setups kept between the runs, one per model, and the
+		//! connections of the model signals marking them as changed
+		QHash<ModelWidget *, GraphicalQueryBuilderSolverCache *> solver_caches;
+		QHash<ModelWidget *, QList<QMetaObject::Connection>> solver_cache_connections;
+
+		//! \brief Solver setup of the current model, created on first use.
+		//! The model edits mark it to be compared with the model on the next run.
+		GraphicalQueryBuilderSolverCache *getSolverCache(void);
+
+		//! \brief Deletes the solver setup of a model, once the model widget is destroyed
+		void dropSolverCache(ModelWidget *model);
 #endif
 
 		static constexpr unsigned Manual=0,
@@ -84,14 +117,25 @@ private:
 		bool eventFilter(QObject *object, QEvent *event) override;
 
 #ifdef GRAPHICAL_QUERY_BUILDER_JOIN_SOLVER
+		//! \brief Refreshes the status tab labels of a report from the progress counters
+		void updateProgress(unsigned mode);
+
+		//! \brief Highlights the tables of a PT_ mode on the scene
+		void progressTables(int mode, bts btss);
+
 		void createThread(void);
 		void destroyThread(bool force);
+
+		//! \brief Stops the running solver, waits for its thread to finish and deletes the solver
+		void joinThread(void);
+
 		void runSQLJoinSolver(void);
 		QGraphicsItem * addPix(QPointF pos, QColor col);
 #endif
 
 public:
 		GraphicalQueryBuilderPathWidget(QWidget *parent = nullptr);
+		~GraphicalQueryBuilderPathWidget(void);
 
 		//! \brief Sets the database model to work on
 		void setModel(ModelWidget *model_wgt);
@@ -117,23 +161,22 @@ public:
 
 public slots:
 #ifdef GRAPHICAL_QUERY_BUILDER_JOIN_SOLVER
-		void resetAutoPath(){auto_path_tw->setRowCount(0);};
+		void resetAutoPath(){auto_paths_model->clear();};
 
 		//! \brief Insert in the auto tab the output of the inference engine
-		void insertAutoRels(paths paths_found);
+		void insertAutoRels(GraphicalQueryBuilderPaths paths_found);
 
-		void handlePathsFound(paths p);
+		void handlePathsFound(GraphicalQueryBuilderPaths p);
 #endif
 private slots:
 		void resetPaths(void);
 #ifdef GRAPHICAL_QUERY_BUILDER_JOIN_SOLVER
-		void automaticPathSelected(int new_row, int new_column, int old_row=0, int old_column=0);
-		void updateProgress(short mode,
-							short st_round, short powN, long long st_comb, int st_found,
-							int sp_current, int sp_current_on, long long sp_found,
-							int st_fround, long long mult_entry, long long mult_entry_on, long long paths_found);
+		//! \brief Refreshes the status tab with the reports marked since the last poll
+		void pollProgress(void);
 		void stopSolver(void);
-		void progressTables(int mode, bts btss);
+
+		//! \brief Draws the next highlight queued by the solver, if any
+		void drawHighlight(void);
 #endif
 
 signals:
@@ -0,0 +1,411 @@
+//=======================================================================
+// Copyright (c)
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//=======================================================================
+/**
+ * @file steiner_tree_test.cpp
+ * @brief Randomized checks of the join solver's paal additions, without Qt.
+ *
+ * Once "./setup.sh paal" has copied the headers into paal, build and run it
+ * from the graphicalquerybuilder directory, adding -Ipaal/boost when boost
+ * comes from "./setup.sh boost" rather than from the system :
+ *
+ *   g++ -std=c++14 -O2 -pthread -Ipaal/include \
+ *       tests/steiner_tree_test.cpp -o steiner_tree_test && ./steiner_tree_test
+ *
+ * Every check compares against a brute force or a plain reference on small
+ * random graphs ; the program prints the first failure and returns 1.
+ */
+
+#include "paal/data_structures/metric/graph_metrics.hpp"
+#include "paal/data_structures/metric/lazy_graph_metric.hpp"
+#include "paal/data_structures/set_trie.hpp"
+#include "paal/data_structures/work_stealing_pool.hpp"
+#include "paal/steiner_tree/dreyfus_wagner.hpp"
+#include "paal/steiner_tree/k_best_dreyfus_wagner.hpp"
+#include "paal/utils/k_shortest_simple_paths.hpp"
+
+#include <boost/graph/adjacency_list.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+using edge_prop = boost::property<boost::edge_weight_t, int>;
+using graph = boost::adjacency_list<boost::vecS, boost::vecS, boost::undirectedS,
+                                    boost::property<boost::vertex_color_t, int>,
+                                    edge_prop>;
+using graph_mt = paal::data_structures::graph_metric<graph, int>;
+using lazy_mt = paal::data_structures::lazy_graph_metric<graph, int>;
+using weights = std::map<std::pair<int, int>, int>;
+
+bool check(bool condition, const std::string &what, int iteration) {
+    if (!condition) {
+        std::cout << "FAILED " << what << " at iteration " << iteration
+                  << std::endl;
+    }
+    return condition;
+}
+
+/**
+ * Random graph of n vertices : a spanning tree, unless sparse, plus about n
+ * other edges, without parallel edges.
+ */
+graph make_random_graph(std::mt19937 &rng, int n, int max_weight, bool sparse,
+                        weights &w) {
+    std::vector<std::pair<int, int>> edges;
+    std::vector<int> edge_weights;
+    auto add = [&](int a, int b) {
+        if (a == b || w.count({a, b})) return;
+        int weight = rng() % (max_weight + 1);
+        edges.emplace_back(a, b);
+        edge_weights.push_back(weight);
+        w[{a, b}] = w[{b, a}] = weight;
+    };
+    for (int i = 1; i < n; i++) {
+        if (sparse && rng() % 10 == 0) continue;
+        add(rng() % i, i);
+    }
+    for (int i = 0; i < n; i++) add(rng() % n, rng() % n);
+    return graph(edges.begin(), edges.end(), edge_weights.begin(), n);
+}
+
+/**
+ * Checks that the edges of a tree cost its cost and reach its Steiner
+ * elements.
+ */
+template <typename Solver>
+bool is_consistent(const Solver &solver, const graph_mt &gm,
+                   const std::vector<int> &terminals) {
+    int cost = 0;
+    std::set<int> reached(terminals.begin(), terminals.end());
+    for (auto e : solver.get_edges()) {
+        cost += gm(e.first, e.second);
+        reached.insert(e.first);
+        reached.insert(e.second);
+    }
+    for (auto s : solver.get_steiner_elements()) {
+        if (!reached.count(s)) return false;
+    }
+    return cost == solver.get_cost();
+}
+
+/**
+ * Both engines, with any number of threads, give the same tree as the
+ * recursive one ; removing non-terminals and adding them back gives trees as
+ * cheap as fresh runs.
+ */
+bool test_dreyfus_wagner_engines() {
+    std::mt19937 rng(2);
+    for (int it = 0; it < 300; it++) {
+        weights w;
+        int n = 6 + rng() % 8, k = 2 + rng() % 4;
+        graph g = make_random_graph(rng, n, it % 2 ? 100000 : 3, false, w);
+        graph_mt gm(g);
+        std::vector<int> terminals, non_terminals;
+        for (int i = 0; i < n; i++) (i < k ? terminals : non_terminals).push_back(i);
+
+        auto reference = paal::make_dreyfus_wagner(gm, terminals, non_terminals);
+        reference.solve();
+        if (!check(is_consistent(reference, gm, terminals), "dw tree", it)) return false;
+
+        for (unsigned threads = 1; threads <= 4; threads++) {
+            auto dw = paal::make_dreyfus_wagner(gm, terminals, non_terminals);
+            dw.set_engine(paal::dreyfus_wagner_engine::iterative);
+            dw.set_threads_count(threads);
+            dw.solve();
+            if (!check(dw.get_cost() == reference.get_cost() &&
+                           dw.get_edges() == reference.get_edges() &&
+                           dw.get_steiner_elements() ==
+                               reference.get_steiner_elements(),
+                       "dw iterative engine", it)) {
+                return false;
+            }
+        }
+
+        std::vector<int> removed, kept;
+        for (int v : non_terminals) (rng() % 2 ? removed : kept).push_back(v);
+        auto fresh = paal::make_dreyfus_wagner(gm, terminals, kept);
+        fresh.solve();
+        for (auto engine : {paal::dreyfus_wagner_engine::recursive,
+                            paal::dreyfus_wagner_engine::iterative}) {
+            auto dw = paal::make_dreyfus_wagner(gm, terminals, non_terminals);
+            dw.set_engine(engine);
+            dw.solve();
+            for (int v : removed) dw.remove_non_terminals(std::vector<int>{v});
+            dw.solve();
+            if (!check(dw.get_cost() == fresh.get_cost(),
+                       "dw removed non-terminals", it)) {
+                return false;
+            }
+            dw.add_non_terminals(removed);
+            dw.solve();
+            if (!check(dw.get_cost() == reference.get_cost() &&
+                           is_consistent(dw, gm, terminals),
+                       "dw added non-terminals", it)) {
+                return false;
+            }
+        }
+
+        auto stopped = paal::make_dreyfus_wagner(gm, terminals, non_terminals);
+        stopped.set_stop_condition([]() { return true; });
+        if (!check(!stopped.solve(), "dw stop condition", it)) return false;
+    }
+    return true;
+}
+
+/**
+ * The k best trees come by non-decreasing cost, the first one being the
+ * Dreyfus-Wagner tree, and no tree comes twice.
+ */
+bool test_k_best_dreyfus_wagner() {
+    std::mt19937 rng(9);
+    for (int it = 0; it < 300; it++) {
+        weights w;
+        int n = 4 + rng() % 10, k = 2 + rng() % 3;
+        graph g = make_random_graph(rng, n, 9, false, w);
+        graph_mt gm(g);
+        std::vector<int> terminals, non_terminals;
+        for (int i = 0; i < n; i++) (i < k ? terminals : non_terminals).push_back(i);
+
+        auto dw = paal::make_dreyfus_wagner(gm, terminals, non_terminals);
+        dw.solve();
+        paal::k_best_dreyfus_wagner<graph_mt, std::vector<int>, std::vector<int>, 64>
+            k_best(gm, terminals, non_terminals);
+        if (it % 2) k_best.set_engine(paal::dreyfus_wagner_engine::iterative);
+
+        std::set<std::vector<std::pair<int, int>>> seen;
+        int last = 0;
+        for (int r = 0; r < 10 && k_best.next(); r++) {
+            if (!check(r > 0 || k_best.get_cost() == dw.get_cost(),
+                       "k-best first tree", it) ||
+                !check(k_best.get_cost() >= last, "k-best order", it) ||
+                !check(is_consistent(k_best, gm, terminals), "k-best tree", it)) {
+                return false;
+            }
+            last = k_best.get_cost();
+            std::vector<std::pair<int, int>> edges;
+            for (auto e : k_best.get_edges()) {
+                edges.emplace_back(std::min(e.first, e.second),
+                                   std::max(e.first, e.second));
+            }
+            std::sort(edges.begin(), edges.end());
+            if (!check(seen.insert(edges).second, "k-best duplicate", it)) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Yen's enumeration gives exactly the simple paths within the budget, found
+ * by a depth-first search, by non-decreasing cost.
+ */
+bool test_k_shortest_simple_paths() {
+    std::mt19937 rng(5);
+    for (int it = 0; it < 2000; it++) {
+        weights w;
+        int n = 3 + rng() % 11;
+        graph g = make_random_graph(rng, n, 5, false, w);
+        graph_mt gm(g);
+        int s = rng() % n, t = rng() % n;
+        if (s == t) continue;
+        std::vector<char> blocked(n);
+        for (auto &b : blocked) b = rng() % 4 == 0;
+        auto vertex_filter = [&](int v) { return !blocked[v]; };
+        auto edge_filter = [&](int u, int v) {
+            return w.count({u, v}) && gm(u, v) == w[{u, v}];
+        };
+        int budget = gm(s, t) + rng() % 12;
+
+        std::multiset<std::pair<int, std::vector<int>>> expected;
+        std::vector<int> path{s};
+        std::vector<char> visited(n);
+        visited[s] = 1;
+        std::function<void(int, int)> dfs = [&](int u, int cost) {
+            if (cost > budget) return;
+            if (u == t) {
+                expected.emplace(cost, path);
+                return;
+            }
+            for (int v = 0; v < n; v++) {
+                if (visited[v] || !edge_filter(u, v)) continue;
+                if (v != t && !vertex_filter(v)) continue;
+                visited[v] = 1;
+                path.push_back(v);
+                dfs(v, cost + w[{u, v}]);
+                path.pop_back();
+                visited[v] = 0;
+            }
+        };
+        dfs(s, 0);
+
+        auto paths = paal::make_k_shortest_simple_paths(g, s, t, budget,
+                                                        vertex_filter, edge_filter);
+        std::multiset<std::pair<int, std::vector<int>>> found;
+        int last = 0;
+        while (paths.next()) {
+            auto &p = paths.get_path();
+            int cost = 0;
+            for (std::size_t i = 0; i + 1 < p.size(); i++) cost += w[{p[i], p[i + 1]}];
+            if (!check(paths.get_cost() >= last, "k shortest paths order", it) ||
+                !check(cost == paths.get_cost(), "k shortest paths cost", it)) {
+                return false;
+            }
+            last = paths.get_cost();
+            found.emplace(cost, std::vector<int>(p.begin(), p.end()));
+        }
+        if (!check(found == expected, "k shortest paths", it)) return false;
+    }
+    return true;
+}
+
+/**
+ * The trie keeps an antichain of sets, as a list of sets checked one by one
+ * does.
+ */
+bool test_set_trie() {
+    std::mt19937 rng(3);
+    for (int it = 0; it < 300; it++) {
+        int universe = 4 + rng() % 14;
+        paal::data_structures::set_trie<int, int> trie;
+        std::map<int, std::vector<int>> reference;
+        int id = 0;
+        for (int step = 0; step < 300; step++) {
+            std::set<int> s;
+            for (int i = rng() % 6; i > 0; i--) s.insert(rng() % universe);
+            std::vector<int> v(s.begin(), s.end());
+
+            bool has_subset = false;
+            for (auto &r : reference) {
+                has_subset = has_subset || std::includes(v.begin(), v.end(),
+                                                         r.second.begin(),
+                                                         r.second.end());
+            }
+            if (!check(trie.has_subset(v) == has_subset, "set trie subset", it)) {
+                return false;
+            }
+            if (has_subset) continue;
+
+            std::set<int> removed, supersets;
+            trie.remove_supersets(v, [&](int x) { removed.insert(x); });
+            for (auto &r : reference) {
+                if (std::includes(r.second.begin(), r.second.end(), v.begin(),
+                                  v.end())) {
+                    supersets.insert(r.first);
+                }
+            }
+            if (!check(removed == supersets, "set trie supersets", it)) return false;
+            for (int x : removed) reference.erase(x);
+
+            if (!check(trie.insert(v, id), "set trie insert", it)) return false;
+            reference[id++] = v;
+            if (!check(trie.size() == reference.size(), "set trie size", it)) {
+                return false;
+            }
+
+            if (rng() % 4 == 0) {
+                auto r = reference.begin();
+                std::advance(r, rng() % reference.size());
+                if (!check(trie.erase(r->second), "set trie erase", it) ||
+                    !check(!trie.erase(r->second), "set trie erase twice", it)) {
+                    return false;
+                }
+                reference.erase(r);
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * The lazy metric answers as the full one, while edges come and go and with
+ * few cached rows.
+ */
+bool test_lazy_graph_metric() {
+    std::mt19937 rng(11);
+    for (int it = 0; it < 300; it++) {
+        weights w;
+        int n = 2 + rng() % 25;
+        graph g = make_random_graph(rng, n, 9, true, w);
+        std::size_t rows = 1 + rng() % 4;
+        lazy_mt lazy(g, rows);
+        for (int step = 0; step < 30; step++) {
+            graph_mt gm(g);
+            for (int q = 0; q < 20; q++) {
+                int a = rng() % n, b = rng() % n, bound = rng() % 12;
+                if (!check(lazy(a, b) == gm(a, b), "lazy metric distance", it) ||
+                    !check(lazy.bounded_distance(a, b, bound) ==
+                               std::min(gm(a, b), bound),
+                           "lazy metric bounded distance", it)) {
+                    return false;
+                }
+            }
+            if (!check(lazy.get_rows_count() <= rows, "lazy metric rows", it)) {
+                return false;
+            }
+
+            int a = rng() % n, b = rng() % n;
+            if (a == b) continue;
+            if (w.count({a, b})) {
+                int weight = w[{a, b}];
+                remove_edge(a, b, g);
+                w.erase({a, b});
+                w.erase({b, a});
+                lazy.edge_removed(a, b, weight);
+            } else {
+                int weight = rng() % 9;
+                add_edge(a, b, edge_prop(weight), g);
+                w[{a, b}] = w[{b, a}] = weight;
+                lazy.edge_added(a, b, weight);
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Each iteration of a parallel loop runs exactly once, however unbalanced
+ * the iterations are and however many loops the pool runs.
+ */
+bool test_work_stealing_pool() {
+    std::mt19937 rng(13);
+    for (unsigned threads = 0; threads <= 6; threads++) {
+        paal::data_structures::work_stealing_pool pool(threads);
+        for (int it = 0; it < 50; it++) {
+            std::size_t count = rng() % 500;
+            std::vector<std::atomic<int>> runs(count);
+            for (auto &r : runs) r = 0;
+            pool.parallel_for(count, [&](std::size_t i) {
+                volatile int spin = 0;
+                for (std::size_t j = 0; j < (i % 7 == 0 ? 20000 : 10); j++) spin = spin + 1;
+                runs[i]++;
+            });
+            for (auto &r : runs) {
+                if (!check(r == 1, "work stealing pool", it)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    bool ok = test_dreyfus_wagner_engines() && test_k_best_dreyfus_wagner() &&
+              test_k_shortest_simple_paths() && test_set_trie() &&
+              test_lazy_graph_metric() && test_work_stealing_pool();
+    std::cout << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+//=======================================================================
+// Copyright (c)
+//
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//=======================================================================
+/**
+ * @file work_stealing_pool.hpp
+ * @brief Fixed pool of threads running parallel loops with work stealing.
+ * @version 1.0
+ */
+#ifndef PAAL_WORK_STEALING_POOL_HPP
+#define PAAL_WORK_STEALING_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace paal {
+namespace data_structures {
+
+/**
+ * Runs the iterations of a loop on a fixed set of threads, the calling thread
+ * being one of them. Each thread starts with an equal share of the
+ * iterations and takes them one by one from the front of its share ; once
+ * it is empty, the thread steals the back half of another thread's share, so
+ * unbalanced iterations keep every thread busy until the loop ends.
+ *
+ * The threads are kept between loops, which makes short loops cheap.
+ */
+class work_stealing_pool {
+  public:
+    /**
+     * Constructor.
+     * @param threads_count number of threads, including the calling one
+     */
+    explicit work_stealing_pool(unsigned threads_count)
+        : m_generation(0), m_busy(0), m_quit(false) {
+        if (threads_count == 0) threads_count = 1;
+        for (unsigned i = 0; i < threads_count; i++) {
+            m_shares.emplace_back(new share());
+        }
+        for (unsigned i = 1; i < threads_count; i++) {
+            m_threads.emplace_back([this, i]() { worker_loop(i); });
+        }
+    }
+
+    work_stealing_pool(const work_stealing_pool &) = delete;
+    work_stealing_pool &operator=(const work_stealing_pool &) = delete;
+
+    ~work_stealing_pool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_quit = true;
+        }
+        m_wake.notify_all();
+        for (auto &thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    /**
+     * Gets the number of threads, including the calling one.
+     */
+    unsigned get_threads_count() const { return m_shares.size(); }
+
+    /**
+     * Runs task(i) for every i in [0, count), returns once all are done.
+     * Not reentrant : task must not call parallel_for on the same pool.
+     */
+    template <typename Task>
+    void parallel_for(std::size_t count, Task task) {
+        std::size_t threads_count = m_shares.size();
+        if (threads_count == 1 || count < 2) {
+            for (std::size_t i = 0; i < count; i++) task(i);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_task = std::ref(task);
+            for (std::size_t i = 0; i < threads_count; i++) {
+                std::lock_guard<std::mutex> share_lock(m_shares[i]->mutex);
+                m_shares[i]->begin = count * i / threads_count;
+                m_shares[i]->end = count * (i + 1) / threads_count;
+            }
+            m_busy = threads_count - 1;
+            m_generation++;
+        }
+        m_wake.notify_all();
+
+        run(0);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_busy == 0; });
+        m_task = nullptr;
+    }
+
+  private:
+    /**
+     * Iterations [begin, end) not yet taken by any thread.
+     */
+    struct share {
+        std::mutex mutex;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+    };
+
+    void worker_loop(unsigned id) {
+        unsigned long seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [&]() { return m_quit || m_generation != seen; });
+                if (m_quit) return;
+                seen = m_generation;
+            }
+            run(id);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_busy--;
+            }
+            m_done.notify_one();
+        }
+    }
+
+    /**
+     * Runs iterations until none is left in any share.
+     */
+    void run(std::size_t id) {
+        std::size_t i;
+        while (take(id, i) || steal(id, i)) {
+            m_task(i);
+        }
+    }
+
+    bool take(std::size_t id, std::size_t &i) {
+        share &own = *m_shares[id];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.begin == own.end) return false;
+        i = own.begin++;
+        return true;
+    }
+
+    /**
+     * Moves the back half of another share to the thread's own share, and
+     * takes its first iteration.
+     */
+    bool steal(std::size_t id, std::size_t &i) {
+        std::size_t threads_count = m_shares.size();
+        for (std::size_t k = 1; k < threads_count; k++) {
+            share &victim = *m_shares[(id + k) % threads_count];
+            std::size_t begin, end;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (victim.begin == victim.end) continue;
+                begin = victim.begin + (victim.end - victim.begin) / 2;
+                end = victim.end;
+                victim.end = begin;
+            }
+            i = begin;
+            if (begin + 1 < end) {
+                share &own = *m_shares[id];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                own.begin = begin + 1;
+                own.end = end;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    std::vector<std::unique_ptr<share>> m_shares; // one per thread, the
+                                                  // calling thread's first
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;                 // guards the fields below
+    std::condition_variable m_wake;     // a loop started, or quit
+    std::condition_variable m_done;     // a thread finished its loop
+    std::function<void(std::size_t)> m_task;
+    unsigned long m_generation;         // number of loops started
+    std::size_t m_busy;                 // threads still running the loop
+    bool m_quit;
+};
+
+} // data_structures
+} // paal
+
+#endif // PAAL_WORK_STEALING_POOL_HPP